@@ -3,6 +3,7 @@
 #include <random>
 #include <algorithm>
 #include <vector>
+#include <array>
 #include <queue>
 #include <memory>
 #include <fstream>
@@ -13,7 +14,30 @@
 #include <chrono>
 #include <string>
 #include <climits>
+#include <cerrno>
+#include <limits>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <type_traits>
+#include <sstream>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
 
 /*
     Bu program, sanal bir ekosistemde hayvanlar (memeliler, bitkiler) simle etmektedir.
@@ -37,6 +61,12 @@ namespace fs = std::filesystem;
 */
 string basePath = "C:\\Users\\Doruk\\env\\tubitak2025\\json\\1\\";
 
+/*
+    logEvents, olay mesajlarnn (doum, saldr, eleme, lm ve adm balklar) konsola yazlp yazlmayacan
+    belirler. Byk poplasyonlu kyaslamalarda kapatlr.
+*/
+bool logEvents = true;
+
 /*
     Simlasyon srasnda kullanacamz sabitler ve global deikenler.
     - PI: 3.141592 deerinde sabit.
@@ -65,41 +95,44 @@ struct AnimalTemplate {
 };
 
 /*
+    Aadaki tr tablolar derlemeye gml varsaylanlardr; kou bunlar dorudan okumaz, bunlardan kurulan
+    (veya senaryo dosyasndan yklenen) SpeciesParameters tablosunu okur (bkz. defaultSpeciesParameters).
+
     Simlasyonda rastgelelik eklemek iin, reme zamanlarn (cooldown) ve
     lm srelerini (deathTime) hayvan trne gre saklyoruz.
     Ayrca bir hayvann bir defada dourabilecei maksimum yavru says (maxBirthNum) da burada.
 */
-int reproductionCooldownRandom[NUM_ANIMALS] = { 300, 300, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000 };
-int deathTimeRandom[NUM_ANIMALS] = { 800, 800, 3300, 3300, 3300, 3300, 3300, 3300, 3300, 3300 };
-int maxBirthNum[NUM_ANIMALS] = { 1,   1,   1,    1,    1,    1,    1,    1,    1,    1 };
+const int reproductionCooldownRandom[NUM_ANIMALS] = { 300, 300, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000 };
+const int deathTimeRandom[NUM_ANIMALS] = { 800, 800, 3300, 3300, 3300, 3300, 3300, 3300, 3300, 3300 };
+const int maxBirthNum[NUM_ANIMALS] = { 1,   1,   1,    1,    1,    1,    1,    1,    1,    1 };
 
 /*
     Herbivor (otul) hayvanlar iin global bir hz buff' (u an 0).
     food_rej_per_step, her admda bitkilerin kendini yenileme miktar (0.1).
 */
-double buff_herbivor_speed = 0;
-double food_rej_per_step = 0.05; // Her admda bitkilerin artan 'food' miktar.
+const double buff_herbivor_speed = 0;
+const double food_rej_per_step = 0.05; // Her admda bitkilerin artan 'food' miktar.
 
 /*
-    animalTemplates haritasnda, tr numarasna gre hayvan zellik arpanlar saklanmaktadr.
-    rnek: {0, {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105}} -> Tavan (Rabbit)
+    animalTemplates tablosunda, tr numarasna gre hayvan zellik arpanlar saklanmaktadr.
+    rnek: {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105} -> Tavan (Rabbit, tr 0)
 */
-std::map<int, AnimalTemplate> animalTemplates = {
+const AnimalTemplate animalTemplates[NUM_ANIMALS] = {
     // Otullar (Herbivores)
-    {0, {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105}},
-    {1, {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105}}, 
-    {2, {1.3, 1.6, 1.1, 1, 0.6, 4000,15000, 5}},
-    {3, {1.2, 1.4, 1.2, 1, 0.9, 4000,15000, 50.0}},
+    {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105},
+    {1.7, 1.8, 1.5, 1, 0.5, 1700, 8000, 105}, 
+    {1.3, 1.6, 1.1, 1, 0.6, 4000,15000, 5},
+    {1.2, 1.4, 1.2, 1, 0.9, 4000,15000, 50.0},
 
     // Hepiller (Omnivores)
-    {4, {1.2, 1.7, 1.4, 1, 0.7, 4000,15000, 5.0}},
-    {5, {1.32, 1.3, 1.5, 1, 0.9, 4000,15000, 55.0}},
+    {1.2, 1.7, 1.4, 1, 0.7, 4000,15000, 5.0},
+    {1.32, 1.3, 1.5, 1, 0.9, 4000,15000, 55.0},
 
     // Etiller (Carnivores)
-    {6, {1.7, 1.9, 1,   1, 0.7, 3500, 15000, 35.0}},
-    {7, {1.25,1.6, 1,   1, 0.8, 4000, 15000, 55.0}},
-    {8, {1.2, 1.2, 1,   1, 1.0, 4000, 15000, 60.0}},
-    {9, {1.3, 1.8, 1,   1, 0.8, 4000, 15000, 20.0}}
+    {1.7, 1.9, 1,   1, 0.7, 3500, 15000, 35.0},
+    {1.25,1.6, 1,   1, 0.8, 4000, 15000, 55.0},
+    {1.2, 1.2, 1,   1, 1.0, 4000, 15000, 60.0},
+    {1.3, 1.8, 1,   1, 0.8, 4000, 15000, 20.0}
 };
 
 /*
@@ -108,43 +141,43 @@ std::map<int, AnimalTemplate> animalTemplates = {
     (Bu rnekte hepsi a=10 ve b=0 ile tutuluyor, yani ok kstlayc deil)
 */
 double a = 10.0;
-std::map<int, AnimalTemplate> animalLimitMax = {
+const AnimalTemplate animalLimitMax[NUM_ANIMALS] = {
     // Otullar
-    {0, {a, a, a, a, a, 250}}, // Rabbit
-    {1, {a, a, a, a, a, 250}}, // Deer
-    {2, {a, a, a, a, a, 250}}, // Squirrel
-    {3, {a, a, a, a, a, 250}}, // Elk
+    {a, a, a, a, a, 250}, // Rabbit
+    {a, a, a, a, a, 250}, // Deer
+    {a, a, a, a, a, 250}, // Squirrel
+    {a, a, a, a, a, 250}, // Elk
     // Hepiller
-    {4, {a, a, a, a, a, 250}}, // Raccoon
-    {5, {a, a, a, a, a, 250}}, // Wild Pig
+    {a, a, a, a, a, 250}, // Raccoon
+    {a, a, a, a, a, 250}, // Wild Pig
     // Etiller
-    {6, {a, a, a, a, a, 250}}, // Fox
-    {7, {a, a, a, a, a, 250}}, // Wolf
-    {8, {a, a, a, a, a, 250}}, // Bear
-    {9, {a, a, a, a, a, 250}}  // Lynx
+    {a, a, a, a, a, 250}, // Fox
+    {a, a, a, a, a, 250}, // Wolf
+    {a, a, a, a, a, 250}, // Bear
+    {a, a, a, a, a, 250}  // Lynx
 };
 
 double b = 0;
-std::map<int, AnimalTemplate> animalLimitMin = {
+const AnimalTemplate animalLimitMin[NUM_ANIMALS] = {
     // Otullar
-    {0, {b, b, b, b, b, 250}}, // Rabbit
-    {1, {b, b, b, b, b, 250}}, // Deer
-    {2, {b, b, b, b, b, 250}}, // Squirrel
-    {3, {b, b, b, b, b, 250}}, // Elk
+    {b, b, b, b, b, 250}, // Rabbit
+    {b, b, b, b, b, 250}, // Deer
+    {b, b, b, b, b, 250}, // Squirrel
+    {b, b, b, b, b, 250}, // Elk
     // Hepiller
-    {4, {b, b, b, b, b, 250}}, // Raccoon
-    {5, {b, b, b, b, b, 250}}, // Wild Pig
+    {b, b, b, b, b, 250}, // Raccoon
+    {b, b, b, b, b, 250}, // Wild Pig
     // Etiller
-    {6, {b, b, b, b, b, 250}}, // Fox
-    {7, {b, b, b, b, b, 250}}, // Wolf
-    {8, {b, b, b, b, b, 250}}, // Bear
-    {9, {b, b, b, b, b, 250}}  // Lynx
+    {b, b, b, b, b, 250}, // Fox
+    {b, b, b, b, b, 250}, // Wolf
+    {b, b, b, b, b, 250}, // Bear
+    {b, b, b, b, b, 250}  // Lynx
 };
 
 /*
     Tm hayvan isimlerinin string gsterimi, index ile eleecek ekilde.
 */
-std::string animalNames[NUM_ANIMALS] = {
+const std::string animalNames[NUM_ANIMALS] = {
     "Rabbit", "Deer", "Squirrel", "Elk",
     "Raccoon", "Wild Pig",
     "Fox", "Wolf", "Bear", "Lynx"
@@ -154,7 +187,7 @@ std::string animalNames[NUM_ANIMALS] = {
     animalSpeciesWeights, hangi trden ne kadar oluturacamzn arlk dalm (distribution).
     rnein [150, 150, 0, 0, 0, 0, 0, 0, 0, 0] -> ilk iki tre (Rabbit, Deer) arlk verdiimiz anlamna gelir.
 */
-std::vector<int> animalSpeciesWeights = {
+const std::vector<int> animalSpeciesWeights = {
     150, 150, 0, 0,
     0, 0,
     0, 0, 0, 0
@@ -165,9 +198,9 @@ std::vector<int> animalSpeciesWeights = {
     Bu dizi hayvann tr indexine gre ayarlanr.
 */
 double r = 0;
-double base_health_decay_rate_arr[NUM_ANIMALS] = { r, r, r, r, r, r, r, r, r, r };
+const double base_health_decay_rate_arr[NUM_ANIMALS] = { r, r, r, r, r, r, r, r, r, r };
 double k = 0;
-double aging_factor_arr[NUM_ANIMALS] = { k, k, k, k, k, k, k, k, k, k };
+const double aging_factor_arr[NUM_ANIMALS] = { k, k, k, k, k, k, k, k, k, k };
 
 /*
     foodChainMatrix, av-avc ilikisini gsteren bir matristir.
@@ -175,7 +208,7 @@ double aging_factor_arr[NUM_ANIMALS] = { k, k, k, k, k, k, k, k, k, k };
     rnein: foodChainMatrix[6][0] = 1 demek, Fox (6) tavan (0) yiyebilir.
     Son stun (NUM_ANIMALS deeri) 'Herbivore' etiketini temsil eder (bitkisel besin).
 */
-int foodChainMatrix[NUM_ANIMALS][NUM_ANIMALS + 1] = {
+const int foodChainMatrix[NUM_ANIMALS][NUM_ANIMALS + 1] = {
     //  Rabbit, Deer, Squirrel, Elk, Raccoon, Wild Pig, Fox, Wolf, Bear, Lynx, Herbivore
     { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }, // Rabbit    
     { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }, // Deer
@@ -189,14 +222,236 @@ int foodChainMatrix[NUM_ANIMALS][NUM_ANIMALS + 1] = {
     { 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0 }  // Lynx
 };
 
+/*
+    FoodChainMasks, foodChainMatrix'in tr bana bit maskesi biimidir (bit i = tr i):
+     - prey[s]: s'nin avlayabildii trler, predators[s]: s'yi avlayabilen trler,
+     - relevant[s]: s'nin komu sorgusunda ilgilendii trler (avlar, avclar ve e aday olarak kendi tr).
+    ift bana matris okumak yerine tek bit testi yaplr; relevant maskesi uzaysal indekse sorgu szgeci olarak verilir.
+    Maskeler SpeciesParameters iinde, tablonun besin zinciri matrisinden bir kez kurulur.
+*/
+static_assert(NUM_ANIMALS <= 32, "Tur maskeleri 32 bitlik");
+const std::uint32_t ALL_SPECIES_MASK = (1u << NUM_ANIMALS) - 1;
+
+struct FoodChainMasks {
+    std::uint32_t prey[NUM_ANIMALS];
+    std::uint32_t predators[NUM_ANIMALS];
+    std::uint32_t relevant[NUM_ANIMALS];
+};
+
+FoodChainMasks buildFoodChainMasks(const int matrix[NUM_ANIMALS][NUM_ANIMALS + 1]) {
+    FoodChainMasks masks = {};
+    for (int predator = 0; predator < NUM_ANIMALS; predator++) {
+        for (int prey = 0; prey < NUM_ANIMALS; prey++) {
+            if (matrix[predator][prey] == 1) {
+                masks.prey[predator] |= 1u << prey;
+                masks.predators[prey] |= 1u << predator;
+            }
+        }
+    }
+    for (int species = 0; species < NUM_ANIMALS; species++) {
+        masks.relevant[species] = masks.prey[species] | masks.predators[species] | (1u << species);
+    }
+    return masks;
+}
+
+/*
+    SpeciesParameters, bir kounun tr bana parametre tablolardr (ablonlar, mutasyon snrlar, reme ve mr
+    rastgelelii, tr arlklar, besin zinciri ve maskeleri, bitki yenilenmesi). Kou balamadan bir kez doldurulur
+    (defaultSpeciesParameters veya loadScenario) ve sonra deimez: Environment ona const referansla, AnimalStore
+    const iaretiyle bakar. Tablo, onu kullanan ortamlardan daha uzun yaamaldr.
+*/
+struct SpeciesParameters {
+    AnimalTemplate templates[NUM_ANIMALS];
+    AnimalTemplate limitMax[NUM_ANIMALS];
+    AnimalTemplate limitMin[NUM_ANIMALS];
+    std::string names[NUM_ANIMALS];
+    int reproductionCooldownRandom[NUM_ANIMALS];
+    int deathTimeRandom[NUM_ANIMALS];
+    int maxBirthNum[NUM_ANIMALS];
+    double healthDecayRate[NUM_ANIMALS];
+    double agingFactor[NUM_ANIMALS];
+    std::vector<int> speciesWeights;
+    int foodChainMatrix[NUM_ANIMALS][NUM_ANIMALS + 1];
+    FoodChainMasks foodChainMasks;      // foodChainMatrix'ten kurulur
+    double foodRejuvenation;            // Bitkilerin adm bana yenilenmesi (food_rej_per_step)
+    double herbivoreSpeedBuff;          // buff_herbivor_speed
+
+    // canEat(), predator trnn prey trn avlayp avlayamayacan dndrr (foodChainMatrix[predator][prey] == 1).
+    bool canEat(int predator, int prey) const {
+        return (foodChainMasks.prey[predator] >> prey) & 1u;
+    }
+
+    // isHerbivore(), trn bitkisel besinle beslenip beslenmediini dndrr (besin zincirinin son stunu).
+    bool isHerbivore(int species) const {
+        return foodChainMatrix[species][NUM_ANIMALS] != 0;
+    }
+};
+
+// buildDefaultSpeciesParameters(), derlemeye gml tablolardan parametre tablosunu kurar.
+SpeciesParameters buildDefaultSpeciesParameters() {
+    SpeciesParameters parameters;
+    for (int i = 0; i < NUM_ANIMALS; i++) {
+        parameters.templates[i] = animalTemplates[i];
+        parameters.limitMax[i] = animalLimitMax[i];
+        parameters.limitMin[i] = animalLimitMin[i];
+        parameters.names[i] = animalNames[i];
+        parameters.reproductionCooldownRandom[i] = reproductionCooldownRandom[i];
+        parameters.deathTimeRandom[i] = deathTimeRandom[i];
+        parameters.maxBirthNum[i] = maxBirthNum[i];
+        parameters.healthDecayRate[i] = base_health_decay_rate_arr[i];
+        parameters.agingFactor[i] = aging_factor_arr[i];
+        std::copy(foodChainMatrix[i], foodChainMatrix[i] + NUM_ANIMALS + 1, parameters.foodChainMatrix[i]);
+    }
+    parameters.speciesWeights = animalSpeciesWeights;
+    parameters.foodChainMasks = buildFoodChainMasks(parameters.foodChainMatrix);
+    parameters.foodRejuvenation = food_rej_per_step;
+    parameters.herbivoreSpeedBuff = buff_herbivor_speed;
+    return parameters;
+}
+
+const SpeciesParameters defaultSpeciesParameters = buildDefaultSpeciesParameters();
+
 /*
     Binom dalm (binomial distribution) fonksiyonu.
-    n deneme iinde p olaslkla baarl olma saysn rastgele dndrr.
+    n deneme iinde p olaslkla baarl olma saysn, verilen retele (r. hayvann CounterRng ak) dndrr.
+    Ters dalm (inversion) yntemiyle tek ekili yapar; olaslklar k = 0'dan balayarak adm adm toplanr.
+    (std::binomial_distribution her arda kurulup birden fazla ekili yapyordu ve sonucu standart ktphaneye balyd.)
+*/
+template <typename Generator>
+int bin_dist(int n, double p, Generator& generator) {
+    double u = generator.uniform();
+    if (p <= 0) return 0;
+    if (p >= 1) return n;
+
+    double ratio = p / (1 - p);
+    double probability = std::pow(1 - p, n);
+    double cumulative = probability;
+    int k = 0;
+    while (u >= cumulative && k < n) {
+        probability *= ratio * (n - k) / (k + 1);
+        cumulative += probability;
+        k++;
+    }
+    return k;
+}
+
+/*
+    rngSeed, kounun (run) kk tohumudur. Tm rastgele ekililer bu tohumdan tretildii iin
+    ayn tohum ve ayn ayarlarla simlasyon, i parac saysndan bamsz olarak aynen tekrarlanr.
+*/
+std::uint64_t rngSeed = std::random_device{}();
+
+/*
+    Rastgele ak alanlar (domain): ayn hayvann farkl amal ekilileri birbiriyle akmasn.
+     - RNG_STEP_DOMAIN: adm iindeki davran ekilileri (dn, alglama, yavru zellikleri, doum says)
+     - RNG_BIRTH_DOMAIN: hayvan depoya eklenirken balang deerleri (salk, mr, cinsiyet vb.)
+     - RNG_SETUP_DOMAIN: balang poplasyonu ve bitkilerin kurulumu
+*/
+const std::uint32_t RNG_STEP_DOMAIN = 0;
+const std::uint32_t RNG_BIRTH_DOMAIN = 1;
+const std::uint32_t RNG_SETUP_DOMAIN = 2;     // Alanlar 8 bite smal (bkz. CounterRng::counterHigh)
+
+/*
+    philox4x32(), Philox4x32-10 saya tabanl retecinin bir bloudur (Salmon vd., "Random123", 2011).
+    128 bitlik saya, 64 bitlik anahtarla 10 tur kartrlr; ayn (anahtar, saya) her zaman ayn sonucu verir.
+*/
+inline std::array<std::uint32_t, 4> philox4x32(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < 10; round++) {
+        std::uint64_t product0 = static_cast<std::uint64_t>(0xD2511F53u) * counter[0];
+        std::uint64_t product1 = static_cast<std::uint64_t>(0xCD9E8D57u) * counter[2];
+        counter = {
+            static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<std::uint32_t>(product1),
+            static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<std::uint32_t>(product0)
+        };
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+    }
+    return counter;
+}
+
+/*
+    CounterRng, (kou tohumu, hayvan ID'si, alan, adm, ekili no) belisinden Philox ile say reten durumsuz bir aktr.
+    Anahtar yalnzca tohumdur; hayvan ID'si, alan, adm ve ekili no sayacn ayr szcklerindedir
+    (saya = { draw, stream, step alt 32 bit, (step st bitleri << 8) | domain }). Bylece farkl tohumlarn
+    aklar akmaz; eleme 2^56 adma kadar birebirdir.
+    rete durumu yoktur; yalnzca ekili sayac (draw) ilerler. mt19937 gibi 5 KB'lk durum kurulmaz,
+    random_device arlmaz; her hayvann ekilileri baka hayvanlardan ve i parac srasndan bamszdr.
+    std dalmlaryla kullanlabilmesi iin UniformRandomBitGenerator arayzn salar.
+*/
+struct CounterRng {
+    using result_type = std::uint64_t;
+    std::uint64_t seed;
+    std::uint32_t stream;       // Hayvan ID'si (kurulum ak iin 0)
+    std::uint32_t domain;
+    std::uint64_t step;
+    std::uint32_t& draw;        // Bu (ak, alan, adm) iin yaplm ekili says
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        std::array<std::uint32_t, 4> block = philox4x32(
+            { draw++, stream, static_cast<std::uint32_t>(step), counterHigh() },
+            { static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) });
+        return (static_cast<std::uint64_t>(block[0]) << 32) | block[1];
+    }
+
+    // Sayacn son szc: admn st bitleri ve alan (alan < 256)
+    std::uint32_t counterHigh() const { return static_cast<std::uint32_t>(step >> 32) << 8 | domain; }
+
+    // [0, 1) aralnda dzgn dalml say
+    double uniform() { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // [0, n) aralnda tam say
+    int below(int n) { return static_cast<int>((*this)() % static_cast<std::uint64_t>(n)); }
+
+    // fillUniform(), sradaki n ekilii uniform() ile bit bit ayn deerlerle out'a yazar (AVX2 varsa 4'erli retir).
+    void fillUniform(double* out, int n);
+};
+
+/*
+    CounterRng::fillUniform(): AVX2 yolunda 4 ekiliin Philox sayalar 64 bitlik eritlerde (st yarlar sfr)
+    birlikte kartrlr. 53 bitlik sonu, iki paraya blnp 2^52 hilesiyle double'a tam olarak evrilir.
 */
-int bin_dist(int n, double p) {
-    static std::mt19937 mt(std::time(nullptr));
-    std::binomial_distribution<int> dist(n, p);
-    return dist(mt);
+inline void CounterRng::fillUniform(double* out, int n) {
+    int i = 0;
+#ifdef __AVX2__
+    const __m256i low32 = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const __m256i multiplier0 = _mm256_set1_epi64x(0xD2511F53ll);
+    const __m256i multiplier1 = _mm256_set1_epi64x(0xCD9E8D57ll);
+    const __m256i exponent52 = _mm256_set1_epi64x(0x4330000000000000ll);
+    const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+    const __m256i counter1 = _mm256_set1_epi64x(stream);
+    const __m256i counter2 = _mm256_set1_epi64x(static_cast<std::uint32_t>(step));
+    const __m256i counter3 = _mm256_set1_epi64x(counterHigh());
+    for (; i + 4 <= n; i += 4) {
+        __m256i c0 = _mm256_and_si256(_mm256_add_epi64(_mm256_set1_epi64x(draw), _mm256_set_epi64x(3, 2, 1, 0)), low32);
+        __m256i c1 = counter1, c2 = counter2, c3 = counter3;
+        std::uint32_t key0 = static_cast<std::uint32_t>(seed);
+        std::uint32_t key1 = static_cast<std::uint32_t>(seed >> 32);
+        for (int round = 0; round < 10; round++) {
+            __m256i product0 = _mm256_mul_epu32(c0, multiplier0);
+            __m256i product1 = _mm256_mul_epu32(c2, multiplier1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(product1, 32), c1), _mm256_set1_epi64x(key0));
+            c1 = _mm256_and_si256(product1, low32);
+            c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(product0, 32), c3), _mm256_set1_epi64x(key1));
+            c3 = _mm256_and_si256(product0, low32);
+            key0 += 0x9E3779B9u;
+            key1 += 0xBB67AE85u;
+        }
+        draw += 4;
+        __m256i bits53 = _mm256_srli_epi64(_mm256_or_si256(_mm256_slli_epi64(c0, 32), c1), 11);
+        __m256d high = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits53, 21), exponent52)), two52);
+        __m256d low = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits53, _mm256_set1_epi64x(0x1FFFFF)), exponent52)), two52);
+        __m256d value = _mm256_add_pd(_mm256_mul_pd(high, _mm256_set1_pd(2097152.0)), low);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(value, _mm256_set1_pd(1.0 / 9007199254740992.0)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = uniform();
+    }
 }
 
 /*
@@ -245,6 +500,249 @@ bool lineCircleIntersection(double A_x, double A_y, double B_x, double B_y,
     return false;
 }
 
+/*
+    FP_CONTRACT_OFF_BEGIN / FP_CONTRACT_OFF_END, aradaki ekirdeklerde kayan nokta birletirmesini (a * b + c'nin tek
+    FMA komutuna dntrlmesi) derleyici bayraklarndan bamsz olarak kapatr. ekirdeklerin skaler ve AVX2 yollar
+    ile -mfma'l ve -mfma'sz derlemeler ancak byle bit bit ayn sonucu verir (checkpoint'ten devam eden koular da).
+    GCC'nin -ffp-contract=fast varsaylan iin "optimize" pragmas, Clang iin STDC FP_CONTRACT kullanlr.
+    GCC ayar farkna ramen ekirdei arana satr ii aar ve birletirmeyi orada yapar; bu yzden blgenin
+    dardan arlan ekirdekleri FP_CONTRACT_OFF_KERNEL ile tanmlanr (GCC'de noinline, ar bana bir kez).
+    MSVC /fp:precise ile birletirme yapmaz; /fp:contract veya /fp:fast ile derlenmemelidir.
+    Blge yalnzca vektrl ekirdekleri kapsar; Animal::update gibi skaler kodun da derlemeler arasnda bit bit
+    ayn kalmas iin tm dosya -ffp-contract=off (MSVC'de /fp:precise) ile derlenmelidir.
+*/
+#if defined(__clang__)
+#define FP_CONTRACT_OFF_BEGIN _Pragma("STDC FP_CONTRACT OFF")
+#define FP_CONTRACT_OFF_END _Pragma("STDC FP_CONTRACT DEFAULT")
+#define FP_CONTRACT_OFF_KERNEL inline
+#elif defined(__GNUC__)
+#define FP_CONTRACT_OFF_BEGIN _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define FP_CONTRACT_OFF_END _Pragma("GCC pop_options")
+#define FP_CONTRACT_OFF_KERNEL __attribute__((noinline))
+#else
+#define FP_CONTRACT_OFF_BEGIN
+#define FP_CONTRACT_OFF_END
+#define FP_CONTRACT_OFF_KERNEL inline
+#endif
+
+FP_CONTRACT_OFF_BEGIN
+
+/*
+    fastExp(), x <= 0 iin e^x yaklamdr (bal hata ~5e-9): x = n*ln2 + r (|r| <= ln2/2) indirgemesi, r iin
+    7. derece Taylor polinomu ve 2^n'nin s bitlerinden kurulmas. detectBatch()'in AVX2 yolu ayn ilemleri ayn
+    srayla yapar; birletirme kapal olduundan (FP_CONTRACT_OFF_BEGIN) iki yol bit bit ayn sonucu verir.
+*/
+inline double fastExp(double x) {
+    const double LOG2E = 1.4426950408889634;
+    const double LN2 = 0.6931471805599453;
+    x = std::max(x, -700.0);
+    double n = std::nearbyint(x * LOG2E);
+    double r = x - n * LN2;
+    double p = 1.0 / 5040;
+    p = p * r + 1.0 / 720;
+    p = p * r + 1.0 / 120;
+    p = p * r + 1.0 / 24;
+    p = p * r + 1.0 / 6;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    std::int64_t bits = (static_cast<std::int64_t>(n) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+/*
+    detectBatch(), Animal::detectAnimals()'n toplu alglama ekirdeidir. Aday hayvanlarn SoA dzenindeki konum
+    (cx, cy) ve gizlilik (stealth) deerleri iin uzakl, alglama olasln
+        clamp((0.5 + detectionSkill - stealth) * 0.65 * exp(-uzaklk / detectionRange), 0, 1)
+    ve rastgele at hesaplar; alglanan adaylar iin detected[k] = 1 yazar. Atlar random akndan aday
+    srasyla ekilir (aday bana bir ekili). AVX2 varsa 4 aday birlikte ilenir, kalanlar skaler yoldan geer.
+    rolls, count elemanl bir alma tamponudur.
+*/
+FP_CONTRACT_OFF_KERNEL void detectBatch(const double* cx, const double* cy, const double* stealth, int count, double x, double y,
+    double detectionSkill, double detectionRange, CounterRng& random, double* rolls, std::uint8_t* detected)
+{
+    const double kk = 0.65;
+    double base = 0.5 + detectionSkill;
+    random.fillUniform(rolls, count);
+
+    int k = 0;
+#ifdef __AVX2__
+    const __m256d vx = _mm256_set1_pd(x), vy = _mm256_set1_pd(y);
+    const __m256d vbase = _mm256_set1_pd(base), vkk = _mm256_set1_pd(kk);
+    const __m256d vrange = _mm256_set1_pd(detectionRange);
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+    const __m256d minExponent = _mm256_set1_pd(-700.0);
+    const __m256d log2e = _mm256_set1_pd(1.4426950408889634), ln2 = _mm256_set1_pd(0.6931471805599453);
+    const __m256d c7 = _mm256_set1_pd(1.0 / 5040), c6 = _mm256_set1_pd(1.0 / 720), c5 = _mm256_set1_pd(1.0 / 120);
+    const __m256d c4 = _mm256_set1_pd(1.0 / 24), c3 = _mm256_set1_pd(1.0 / 6), c2 = _mm256_set1_pd(0.5);
+    for (; k + 4 <= count; k += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(cx + k), vx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(cy + k), vy);
+        __m256d distance = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+
+        // fastExp(-distance / detectionRange)
+        __m256d e = _mm256_max_pd(_mm256_div_pd(_mm256_sub_pd(zero, distance), vrange), minExponent);
+        __m256d n = _mm256_round_pd(_mm256_mul_pd(e, log2e), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_sub_pd(e, _mm256_mul_pd(n, ln2));
+        __m256d p = c7;
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), c6);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), c5);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), c4);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), c3);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), c2);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), one);
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), one);
+        __m256i exponent = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)),
+            _mm256_set1_epi64x(1023)), 52);
+        __m256d falloff = _mm256_mul_pd(p, _mm256_castsi256_pd(exponent));
+
+        __m256d probability = _mm256_mul_pd(_mm256_sub_pd(vbase, _mm256_loadu_pd(stealth + k)), vkk);
+        probability = _mm256_mul_pd(probability, falloff);
+        probability = _mm256_max_pd(_mm256_min_pd(probability, one), zero);
+
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(rolls + k), probability, _CMP_LT_OQ));
+        detected[k] = mask & 1;
+        detected[k + 1] = (mask >> 1) & 1;
+        detected[k + 2] = (mask >> 2) & 1;
+        detected[k + 3] = (mask >> 3) & 1;
+    }
+#endif
+    for (; k < count; k++) {
+        double dx = cx[k] - x;
+        double dy = cy[k] - y;
+        double distance = std::sqrt(dx * dx + dy * dy);
+        double probability = (base - stealth[k]) * kk;
+        probability *= fastExp((0.0 - distance) / detectionRange);
+        probability = std::clamp(probability, 0.0, 1.0);
+        detected[k] = rolls[k] < probability;
+    }
+}
+
+FP_CONTRACT_OFF_END
+
+FP_CONTRACT_OFF_BEGIN
+
+/*
+    fastSinCos(), sin ve cos'u birlikte hesaplar (mutlak hata ~1e-11): a en yakn pi/2 katna indirgenir
+    (|r| <= pi/4), r iin Taylor polinomlar hesaplanr ve eyree gre yer/iaret deitirilir.
+    moveAnimalsBatch()'in AVX2 yolu ayn ilemleri ayn srayla yapar; birletirme kapal olduundan
+    (FP_CONTRACT_OFF_BEGIN) iki yol ve -mfma'l/-mfma'sz derlemeler bit bit ayn sonucu verir.
+*/
+inline void fastSinCos(double angle, double& sinOut, double& cosOut) {
+    const double TWO_OVER_PI = 0.6366197723675814;
+    const double PI_OVER_2_HIGH = 1.5707963267341256;      // pi/2'nin ilk 33 biti (q * PI_OVER_2_HIGH tam kar)
+    const double PI_OVER_2_LOW = 6.077100506506192e-11;     // pi/2 - PI_OVER_2_HIGH
+    double q = std::nearbyint(angle * TWO_OVER_PI);
+    double r = (angle - q * PI_OVER_2_HIGH) - q * PI_OVER_2_LOW;
+    double r2 = r * r;
+
+    double sinR = -1.0 / 39916800;
+    sinR = sinR * r2 + 1.0 / 362880;
+    sinR = sinR * r2 - 1.0 / 5040;
+    sinR = sinR * r2 + 1.0 / 120;
+    sinR = sinR * r2 - 1.0 / 6;
+    sinR = sinR * r2 * r + r;
+
+    double cosR = 1.0 / 479001600;
+    cosR = cosR * r2 - 1.0 / 3628800;
+    cosR = cosR * r2 + 1.0 / 40320;
+    cosR = cosR * r2 - 1.0 / 720;
+    cosR = cosR * r2 + 1.0 / 24;
+    cosR = cosR * r2 - 0.5;
+    cosR = cosR * r2 + 1.0;
+
+    int quadrant = static_cast<int>(q) & 3;
+    double s = (quadrant & 1) ? cosR : sinR;
+    double c = (quadrant & 1) ? sinR : cosR;
+    sinOut = (quadrant & 2) ? -s : s;
+    cosOut = ((quadrant + 1) & 2) ? -c : c;
+}
+
+// wrapCoordinate(), bir admlk hareketle [-size, 2*size) aralna kabilen koordinat [0, size) aralna dndrr.
+inline double wrapCoordinate(double value, double size) {
+    if (value < 0) value += size;
+    if (value >= size) value -= size;
+    return value;
+}
+
+/*
+    moveAnimalsBatch(), hareket aamasnn toplu ekirdeidir: her hayvan yn (angle) dorultusunda bu admn
+    mesafesi (distance) kadar ilerletir, koordinatlar dnya snrlar iine sarar ve mesafeyi sfrlar.
+    AVX2 varsa 4 hayvan birlikte ilenir; kalanlar skaler yoldan ayn ilemlerle geer.
+*/
+FP_CONTRACT_OFF_KERNEL void moveAnimalsBatch(double* x, double* y, const double* angle, double* distance, int count,
+    double width, double height)
+{
+    int i = 0;
+#ifdef __AVX2__
+    const __m256d twoOverPi = _mm256_set1_pd(0.6366197723675814);
+    const __m256d piOver2High = _mm256_set1_pd(1.5707963267341256), piOver2Low = _mm256_set1_pd(6.077100506506192e-11);
+    const __m256d s11 = _mm256_set1_pd(-1.0 / 39916800), s9 = _mm256_set1_pd(1.0 / 362880), s7 = _mm256_set1_pd(-1.0 / 5040);
+    const __m256d s5 = _mm256_set1_pd(1.0 / 120), s3 = _mm256_set1_pd(-1.0 / 6);
+    const __m256d c12 = _mm256_set1_pd(1.0 / 479001600), c10 = _mm256_set1_pd(-1.0 / 3628800), c8 = _mm256_set1_pd(1.0 / 40320);
+    const __m256d c6 = _mm256_set1_pd(-1.0 / 720), c4 = _mm256_set1_pd(1.0 / 24), c2 = _mm256_set1_pd(-0.5);
+    const __m256d one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd(), signBit = _mm256_set1_pd(-0.0);
+    const __m256d vwidth = _mm256_set1_pd(width), vheight = _mm256_set1_pd(height);
+    const __m256i bit0 = _mm256_set1_epi64x(1), bit1 = _mm256_set1_epi64x(2);
+
+    auto wrap = [zero](__m256d value, __m256d size) {
+        value = _mm256_add_pd(value, _mm256_and_pd(_mm256_cmp_pd(value, zero, _CMP_LT_OQ), size));
+        return _mm256_sub_pd(value, _mm256_and_pd(_mm256_cmp_pd(value, size, _CMP_GE_OQ), size));
+    };
+
+    for (; i + 4 <= count; i += 4) {
+        __m256d a = _mm256_loadu_pd(angle + i);
+        __m256d q = _mm256_round_pd(_mm256_mul_pd(a, twoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_sub_pd(_mm256_sub_pd(a, _mm256_mul_pd(q, piOver2High)), _mm256_mul_pd(q, piOver2Low));
+        __m256d r2 = _mm256_mul_pd(r, r);
+
+        __m256d sinR = s11;
+        sinR = _mm256_add_pd(_mm256_mul_pd(sinR, r2), s9);
+        sinR = _mm256_add_pd(_mm256_mul_pd(sinR, r2), s7);
+        sinR = _mm256_add_pd(_mm256_mul_pd(sinR, r2), s5);
+        sinR = _mm256_add_pd(_mm256_mul_pd(sinR, r2), s3);
+        sinR = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(sinR, r2), r), r);
+
+        __m256d cosR = c12;
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), c10);
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), c8);
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), c6);
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), c4);
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), c2);
+        cosR = _mm256_add_pd(_mm256_mul_pd(cosR, r2), one);
+
+        // eyrek: tek eyreklerde sin ile cos yer deitirir, ardndan iaretler evrilir
+        __m256i quadrant = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+        __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quadrant, bit0), bit0));
+        __m256d negateSin = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quadrant, bit1), bit1));
+        __m256d negateCos = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+            _mm256_and_si256(_mm256_add_epi64(quadrant, bit0), bit1), bit1));
+        __m256d sinA = _mm256_blendv_pd(sinR, cosR, swap);
+        __m256d cosA = _mm256_blendv_pd(cosR, sinR, swap);
+        sinA = _mm256_xor_pd(sinA, _mm256_and_pd(negateSin, signBit));
+        cosA = _mm256_xor_pd(cosA, _mm256_and_pd(negateCos, signBit));
+
+        __m256d d = _mm256_loadu_pd(distance + i);
+        __m256d nx = _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_mul_pd(cosA, d));
+        __m256d ny = _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(sinA, d));
+        _mm256_storeu_pd(x + i, wrap(nx, vwidth));
+        _mm256_storeu_pd(y + i, wrap(ny, vheight));
+        _mm256_storeu_pd(distance + i, zero);
+    }
+#endif
+    for (; i < count; i++) {
+        double sinA, cosA;
+        fastSinCos(angle[i], sinA, cosA);
+        x[i] = wrapCoordinate(x[i] + cosA * distance[i], width);
+        y[i] = wrapCoordinate(y[i] + sinA * distance[i], height);
+        distance[i] = 0;
+    }
+}
+
+FP_CONTRACT_OFF_END
+
 /*
     leri deklarasyonlar (forward declarations):
     Kodun aknda nce kullanlp sonra tanmlanan snflar.
@@ -252,6 +750,7 @@ bool lineCircleIntersection(double A_x, double A_y, double B_x, double B_y,
 class QuadTree;
 class Entity;
 class Animal;
+class AnimalStore;
 class Plant;
 class BirthQueue;
 
@@ -337,10 +836,325 @@ public:
     }
 };
 
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    AnimalHandle, bir hayvana admlar boyunca tutulabilen kalc referanstr (slot + nesil).
+    Depo satr indeksleri sktrma srasnda kayar; handle ise hayvann slotunu gsterir ve
+    slot her lmde yeni bir nesle getii iin lm bir hayvana ait handle O(1) srede tannr.
+*/
+struct AnimalHandle {
+    int slot = -1;              // -1: bo handle (hedef yok)
+    unsigned generation = 0;
+
+    bool isNull() const { return slot < 0; }
+    bool operator==(const AnimalHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const AnimalHandle& other) const { return !(*this == other); }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    AnimalStore, tm hayvan poplasyonunu "structure-of-arrays" (SoA) dzeninde saklar.
+    Her zellik ayr ve bitiik bir stunda (vector) tutulur; i. hayvann verileri her stunun i. elemandr.
+    Bylece update, alglama ve da aktarma dngleri, her hayvan iin ayr bir nesneye iareti takip etmeden
+    bellei srayla tarayabilir. Animal snf ise bu depodaki bir satra bakan, indeks tabanl bir grnmdr.
+
+    len hayvanlar hemen silinmez: kill() satr iaretler (tombstone) ve slotunun neslini artrr.
+    Adm bana bir kez arlan compact(), iaretli satrlar tek geite (O(N)) atar; sra korunur.
+*/
+class AnimalStore {
+public:
+    // Kimlik, konum ve yn stunlar
+    std::vector<int> id;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> angle;
+    std::vector<double> last_change;
+    std::vector<double> max_turn_rate;
+
+    // Hz, gizlilik ve alglama zellikleri (traits)
+    std::vector<double> speed_coefficient;
+    std::vector<double> current_speed;
+    std::vector<double> move_distance;      // bu admda alnacak yol (moveForward yazar, hareket aamas uygular)
+    std::vector<double> detection_range;
+    std::vector<double> detection_skill;
+    std::vector<double> stealth_level;
+    std::vector<double> current_stealth;
+
+    // Doumdaki zellikler (yalanma ve gebelikle deimez; adm istatistiklerinde kullanlr)
+    std::vector<double> birth_speed;
+    std::vector<double> birth_stealth;
+    std::vector<double> birth_detection;
+
+    // Alk, salk, durum ve yalanma stunlar
+    std::vector<double> maxHunger;
+    std::vector<double> hunger;
+    std::vector<double> maxHealth;
+    std::vector<double> health;
+    std::vector<int> state;
+    std::vector<int> species;
+    std::vector<int> age;
+    std::vector<long long> death_time;
+    std::vector<double> aging_factor;
+    std::vector<double> base_health_decay_rate;
+
+    // reme stunlar (vector<bool> yerine char: her eleman ayr ayr adreslenebilsin)
+    std::vector<int> reproduction_cooldown;
+    std::vector<char> is_ready_to_reproduce;
+    std::vector<char> male;
+    std::vector<char> isPregnant;
+    std::vector<char> statsReduced;             // Gebelik srasnda yetenekler azaltld m?
+    std::vector<std::array<double, 6>> Womb;    // Gebelik (rahim) verileri
+
+    // Hedef ve alglama listeleri. Hedef admlar boyunca tutulduu iin handle'dr; alglama listeleri
+    // her adm yeniden kurulur ve depo indeksleri tutar (compact() bu indeksleri yeni satrlara tar).
+    std::vector<AnimalHandle> currentTarget;
+    std::vector<std::vector<int>> detectedAnimals;
+    std::vector<std::vector<Entity*>> detectedEntities;
+    std::vector<std::vector<Plant*>> detectedPlants;
+
+    // Verlet komu listeleri (bkz. Environment::refreshNeighbourLists). nbellektir: checkpoint'e yazlmaz.
+    std::vector<std::vector<int>> neighbours;   // Aday komularn depo indeksleri (artan srada)
+    std::vector<double> neighbourX;             // Listenin kurulduu (referans) konum
+    std::vector<double> neighbourY;
+    std::vector<double> neighbourRange;         // Listenin kurulduu alglama menzili; < 0: liste yok
+
+    // Handle stunlar: satrn slotu ve l iareti
+    std::vector<int> slot;
+    std::vector<char> tombstone;
+
+    // Hayvann bu admdaki ekili sayac (bkz. CounterRng); beginStep() ile sfrlanr
+    std::vector<std::uint32_t> rngDraws;
+    long long currentStep = 0;
+    std::uint64_t seed = rngSeed;       // Ortamn kk tohumu (bkz. Environment::setSeed)
+
+    BirthQueue* birthQueuePtr = nullptr;
+    const SpeciesParameters* parameters = &defaultSpeciesParameters;     // Tr tablolar (yalnzca okunur)
+
+    size_t size() const { return id.size(); }
+    bool empty() const { return id.empty(); }
+
+    /*
+        add(), depoya yeni bir hayvan satr ekler ve indeksini dndrr.
+        Balang deerleri (alk, salk, mr, cinsiyet vb.) eski Animal kurucusundaki gibi atanr.
+    */
+    int add(int id_, double x_, double y_, double speed, double detectionRange, int species_,
+        double stealth, double detection);
+
+    // handle(), index numaral hayvann kalc handle'n dndrr.
+    AnimalHandle handle(int index) const {
+        int s = slot[index];
+        return { s, slotGeneration[s] };
+    }
+
+    // resolve(), handle'n gsterdii hayvann gncel indeksini dndrr; hayvan ldyse veya handle bosa -1.
+    int resolve(AnimalHandle h) const {
+        if (h.isNull() || slotGeneration[h.slot] != h.generation) {
+            return -1;
+        }
+        return slotRow[h.slot];
+    }
+
+    bool isDead(int index) const { return tombstone[index]; }
+
+    /*
+        kill(), index numaral hayvan l olarak iaretler. Satr compact() arlana kadar yerinde kalr,
+        ancak slotun nesli hemen artrld iin bu hayvana ait tm handle'lar geersiz olur.
+    */
+    void kill(int index) {
+        if (tombstone[index]) {
+            return;
+        }
+        tombstone[index] = true;
+        slotGeneration[slot[index]]++;
+    }
+
+    /*
+        compact(), l iaretli satrlar tm stunlardan tek geite siler (sra korunur) ve
+        silinen hayvan saysn dndrr. newIndex[eski indeks] yeni indeksi (silindiyse -1) verir;
+        uzaysal indeks gibi depo indeksi tutan yaplar bu tabloyla gncellenebilir.
+        Alglama listelerindeki l hayvanlar karlr, kalanlar yeni indekslere tanr.
+    */
+    int compact(std::vector<int>& newIndex) {
+        int count = static_cast<int>(size());
+        newIndex.assign(count, -1);
+        int alive = 0;
+        for (int i = 0; i < count; i++) {
+            if (!tombstone[i]) {
+                newIndex[i] = alive++;
+            }
+            else {
+                freeSlots.push_back(slot[i]);
+            }
+        }
+        if (alive == count) {
+            return 0;
+        }
+
+        forEachColumn([&newIndex, count, alive](auto& column) {
+            for (int i = 0; i < count; i++) {
+                if (newIndex[i] >= 0 && newIndex[i] != i) {
+                    column[newIndex[i]] = std::move(column[i]);
+                }
+            }
+            column.resize(alive);
+        });
+
+        for (int i = 0; i < alive; i++) {
+            slotRow[slot[i]] = i;
+
+            auto& detected = detectedAnimals[i];
+            size_t kept = 0;
+            for (int other : detected) {
+                if (newIndex[other] >= 0) {
+                    detected[kept++] = newIndex[other];
+                }
+            }
+            detected.resize(kept);
+
+            // Eski -> yeni indeks elemesi artan olduundan komu listeleri sral kalr
+            auto& list = neighbours[i];
+            kept = 0;
+            for (int other : list) {
+                if (newIndex[other] >= 0) {
+                    list[kept++] = newIndex[other];
+                }
+            }
+            list.resize(kept);
+        }
+        return count - alive;
+    }
+
+    /*
+        copyVisibleState(), update srasnda dier hayvanlarn okuduu stunlar (konum, tr, durum, salk,
+        hz, reme bilgileri) from deposundan kopyalar. Paralel admda "nceki durum" tamponu olarak kullanlr;
+        dier stunlar bo kalr.
+    */
+    void copyVisibleState(const AnimalStore& from) {
+        id = from.id;
+        x = from.x;
+        y = from.y;
+        species = from.species;
+        state = from.state;
+        health = from.health;
+        current_speed = from.current_speed;
+        is_ready_to_reproduce = from.is_ready_to_reproduce;
+        male = from.male;
+        isPregnant = from.isPregnant;
+    }
+
+    // beginStep(), yeni admn numarasn kaydeder ve hayvanlarn ekili sayalarn sfrlar.
+    void beginStep(long long step) {
+        currentStep = step;
+        std::fill(rngDraws.begin(), rngDraws.end(), 0);
+    }
+
+    // Tm stunlar iin nceden yer ayrr.
+    void reserve(size_t n) {
+        forEachColumn([n](auto& column) { column.reserve(n); });
+    }
+
+    // Tm hayvanlar siler.
+    void clear() {
+        forEachColumn([](auto& column) { column.clear(); });
+        slotRow.clear();
+        slotGeneration.clear();
+        freeSlots.clear();
+    }
+
+    /*
+        isConsistent(), stun boylarnn eit olduunu, satrlarn slotlaryla karlkl eletiini, alglama
+        listelerinin ve hedef handle'larnn geerli satrlar/slotlar gsterdiini, tr ve durum deerlerinin
+        tanml aralkta olduunu denetler (dardan okunan depo verisinin dorulamas iin).
+    */
+    bool isConsistent();
+
+    /*
+        forEachTable(), verilen ilemi nbellek dndaki tm stunlara ve slot tablosuna (slotRow, slotGeneration,
+        freeSlots) uygular. Deponun tamamn srayla yazan ve ayn srayla geri okuyan kod (checkpoint) bunu kullanr;
+        okumadan sonra resetNeighbourLists() arlmaldr.
+    */
+    template <typename F>
+    void forEachTable(F f) {
+        forEachStateColumn(f);
+        f(slotRow); f(slotGeneration); f(freeSlots);
+    }
+
+    /*
+        resetNeighbourLists(), komu listesi stunlarn hayvan saysna getirir ve tm listeleri geersiz klar;
+        bir sonraki yenilemede hepsi batan kurulur.
+    */
+    void resetNeighbourLists() {
+        size_t count = size();
+        neighbours.resize(count);
+        for (auto& list : neighbours) {
+            list.clear();
+        }
+        neighbourX.assign(x.begin(), x.end());
+        neighbourY.assign(y.begin(), y.end());
+        neighbourRange.assign(count, -1);
+    }
+
+private:
+    // Slot tablosu: slot -> gncel satr ve nesil. Boalan slotlar freeSlots ile yeniden kullanlr.
+    std::vector<int> slotRow;
+    std::vector<unsigned> slotGeneration;
+    std::vector<int> freeSlots;
+
+    // allocateSlot(), yeni hayvana bir slot verir (varsa boalm bir slot, nesli korunarak).
+    int allocateSlot(int row) {
+        int s;
+        if (!freeSlots.empty()) {
+            s = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            s = static_cast<int>(slotRow.size());
+            slotRow.push_back(-1);
+            slotGeneration.push_back(0);
+        }
+        slotRow[s] = row;
+        return s;
+    }
+
+    // Verilen ilemi her stuna uygular (ekleme/silme srasnda stunlarn boyu hep eit kalmal).
+    template <typename F>
+    void forEachColumn(F f) {
+        forEachStateColumn(f);
+        f(neighbours); f(neighbourX); f(neighbourY); f(neighbourRange);
+    }
+
+    // nbellek (komu listeleri) dndaki stunlar
+    template <typename F>
+    void forEachStateColumn(F f) {
+        f(id); f(x); f(y); f(angle); f(last_change); f(max_turn_rate);
+        f(speed_coefficient); f(current_speed); f(move_distance); f(detection_range); f(detection_skill);
+        f(stealth_level); f(current_stealth);
+        f(birth_speed); f(birth_stealth); f(birth_detection);
+        f(maxHunger); f(hunger); f(maxHealth); f(health); f(state); f(species); f(age);
+        f(death_time); f(aging_factor); f(base_health_decay_rate);
+        f(reproduction_cooldown); f(is_ready_to_reproduce); f(male); f(isPregnant); f(statsReduced); f(Womb);
+        f(currentTarget); f(detectedAnimals); f(detectedEntities); f(detectedPlants);
+        f(slot); f(tombstone); f(rngDraws);
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    StepIntent, paralel admda bir hayvann kendi satr dnda yapaca yazmalar (baka hayvana saldr,
+    bitki yeme, iftleme, doum kuyruu) tutar. Paralel "karar ve hareket" aamasnda her hayvan yalnzca
+    kendi satrna ve kendi kaydna yazar; kaytlar aama sonunda tek i paracnda, hayvan srasyla uygulanr.
+*/
+struct StepIntent {
+    int births = 0;             // Doum kuyruuna eklenecek yavru says
+    int attackTarget = -1;      // Saldrlacak hayvann indeksi
+    Plant* plant = nullptr;     // Yenecek bitki
+    int mateWith = -1;          // iftleilecek hayvann indeksi
+};
+
 /*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
 /*
     Animal (Hayvan) snf, evre iinde hareket edebilen, reme ve yeme fonksiyonlarna sahip bir varlktr.
-    zellikleri:
+    zellikleri (AnimalStore stunlarnda tutulur):
      - x,y: Konum.
      - angle: Hareket yn (radyan cinsinden).
      - speed_coefficient: Temel hz deeri.
@@ -349,93 +1163,57 @@ public:
      - detection_skill: Alglama yetenei.
      - hunger, health, age vb. hayvann durumsal deikenleri.
      - birthQueuePtr: Doum ilemlerini takip eden kuyrukla etkileim (yeni hayvan eklenmesi vs.)
+
+    Animal nesnesi kendi verisini tutmaz; yalnzca (store, index) iftidir ve kopyalanmas ucuzdur.
+    Depodan hayvan silindiinde indeksler kayabilecei iin grnmler admlar arasnda saklanmamaldr.
+
+    update() srasnda dier hayvanlarn verileri readStore'dan (adm bandaki kopya) okunur ve bakalarna
+    yaplacak yazmalar intent kaydna braklr (i parac saysndan bamsz olarak; tek i parackl admda da).
+    update() bu yzden intent ister; intent'siz grnmler yalnzca okuma ve applyIntent() iin kullanlr.
 */
 class Animal {
 protected:
-    int id;
-    double x_coordinate;
-    double y_coordinate;
-    double angle;
-    double last_change;
-    double speed_coefficient;
-    double current_speed;
-    double detection_range;
-    double detection_skill;
-    std::vector<Animal*>* animalsPtr;
-    double maxHunger;
-    double hunger;
-    double maxHealth;
-    double health;
-    int state;
-    int age;
-    long long death_time;
-    double max_turn_rate;
-    int species;
-    int reproduction_cooldown;
-    bool is_ready_to_reproduce;
-    bool male;
-    bool isPregnant;
-    bool statsReduced;            // Gebelik srasnda yetenekler azaltld m?
-
-    // Gebelik (rahim) verileri
-    vector<double> Womb;
-
-    BirthQueue* birthQueuePtr;
-
-    double stealth_level;
-    double current_stealth;
-    double aging_factor;
-    double base_health_decay_rate;
-    Animal* currentTarget;
+    AnimalStore* store;
+    int index;
+    AnimalStore* readStore;     // Komu hayvanlarn okunduu depo
+    StepIntent* intent;         // nullptr deilse bakalarna yaplacak yazmalar buraya kaydedilir
+
+    // detectAnimals() iin aday tamponlar (SoA); her i paracna bir tane, arlar arasnda yeniden kullanlr.
+    struct DetectionScratch {
+        std::vector<int> candidates;
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> stealth;
+        std::vector<double> rolls;
+        std::vector<std::uint8_t> detected;
+    };
+
+    static DetectionScratch& detectionScratch() {
+        thread_local DetectionScratch scratch;
+        return scratch;
+    }
+
+    // parameters(), hayvann deposunun bal olduu tr tablolardr.
+    const SpeciesParameters& parameters() const { return *store->parameters; }
 
 public:
     /*
         Animal kurucusu (constructor). Parametreler:
-         - id_: Hayvan kimlii
-         - x,y: Balang konumu
-         - speed: Hz arpan
-         - detectionRange: Alglama mesafesi
-         - species_: Tr kimlii
-         - stealth: Gizlilik seviyesi
-         - detection: Alglama becerisi
-         - animalsPtr_: Hayvanlarn sakland vektrn iaretisi
-         - birthQueuePtr_: Doum kuyruu iaretisi
-    */
-    Animal(int id_, double x, double y, double speed, double detectionRange, int species_,
-        double stealth, double detection,
-        std::vector<Animal*>* animalsPtr_, BirthQueue* birthQueuePtr_)
-        : id(id_),
-        x_coordinate(x),
-        y_coordinate(y),
-        angle(0),
-        last_change(0),
-        speed_coefficient(speed),
-        current_speed(speed_coefficient),
-        detection_range(detectionRange),
-        detection_skill(detection),
-        animalsPtr(animalsPtr_),
-        maxHunger(100),
-        hunger(maxHunger* (0.2 + ((std::mt19937{ std::random_device{}() }() % 100) / 100) * 0.6)),
-        maxHealth(100 + (std::mt19937{ std::random_device{}() }() % 50)),
-        health(maxHealth),
-        state(Idle),
-        age(0),
-        death_time(animalTemplates[species_].deathTime + (std::mt19937{ std::random_device{}() }() % deathTimeRandom[species_])),
-        max_turn_rate(PI / 4),
-        species(species_),
-        reproduction_cooldown(animalTemplates[species_].reproductionCooldown + (std::mt19937{ std::random_device{}() }() % reproductionCooldownRandom[species_])),
-        is_ready_to_reproduce(false),
-        male(rand() % 2 == 0),
-        isPregnant(false),
-        statsReduced(false),
-        birthQueuePtr(birthQueuePtr_),
-        stealth_level(stealth),
-        current_stealth(stealth),
-        aging_factor(aging_factor_arr[species_]),
-        base_health_decay_rate(base_health_decay_rate_arr[species_]),
-        currentTarget(nullptr)
+         - store_: Hayvan verilerinin tutulduu SoA deposu
+         - index_: Hayvann depodaki satr numaras
+         - readStore_: Komularn okunaca depo (varsaylan: store_)
+         - intent_: update() srasnda bakalarna yaplacak yazmalarn kayd (update() iin gerekli)
+    */
+    Animal(AnimalStore* store_, int index_, AnimalStore* readStore_ = nullptr, StepIntent* intent_ = nullptr)
+        : store(store_), index(index_), readStore(readStore_ ? readStore_ : store_), intent(intent_)
     {}
 
+    // rng(), hayvann kendi rastgele akn dndrr.
+    CounterRng rng() {
+        return CounterRng{ store->seed, static_cast<std::uint32_t>(store->id[index]), RNG_STEP_DOMAIN,
+            static_cast<std::uint64_t>(store->currentStep), store->rngDraws[index] };
+    }
+
     /*
         TRKE:
         applyAging(), hayvann yalanmasn simle eder.
@@ -443,7 +1221,16 @@ public:
         Ayn zamanda maksimum sal debilir.
     */
     void applyAging() {
-        maxHealth -= base_health_decay_rate;
+        AnimalStore& s = *store;
+        double& maxHealth = s.maxHealth[index];
+        double& health = s.health[index];
+        double& speed_coefficient = s.speed_coefficient[index];
+        double& detection_range = s.detection_range[index];
+        double& stealth_level = s.stealth_level[index];
+        double& detection_skill = s.detection_skill[index];
+        double aging_factor = s.aging_factor[index];
+
+        maxHealth -= s.base_health_decay_rate[index];
         health = min(health, maxHealth);
 
         speed_coefficient -= speed_coefficient * aging_factor;
@@ -461,32 +1248,34 @@ public:
         }
     }
 
-    // Hayvann o an alglad dier hayvanlar/entiteler/bitkiler
-    vector<Animal*> detectedAnimals;
-    vector<Entity*> detectedEntities;
-    vector<Plant*> detectedPlants;
+    // Hayvann o an alglad dier hayvanlar (depo indeksleri)/entiteler/bitkiler
+    std::vector<int>& detectedAnimals() { return store->detectedAnimals[index]; }
+    std::vector<Entity*>& detectedEntities() { return store->detectedEntities[index]; }
+    std::vector<Plant*>& detectedPlants() { return store->detectedPlants[index]; }
 
     // Getter-Setter metodlar
-    double getX() const { return x_coordinate; }
-    double getY() const { return y_coordinate; }
-    void setX(double x) { x_coordinate = x; }
-    void setY(double y) { y_coordinate = y; }
-    double getAngle() const { return angle; }
-    double getHealth() const { return health; }
-    void setHealth(double h) { health = h; }
-    double getHunger() const { return hunger; }
-    int getState() const { return state; }
-    double getRange() const { return detection_range; }
-    int getId() const { return id; }
-    double getSpeed() const { return current_speed; }
-    int getSpecies() const { return species; }
-    double getStealthLevel() const { return stealth_level; }
-    double getDetectionSkill() const { return detection_skill; }
-    void setAngle(double ang) { angle = ang; }
-    double getFoodCapacity() const { return animalTemplates[species].foodCapacity; }
-    double getCurrentStealth() const { return current_stealth; }
-    bool isMale() const { return male; }
-    Animal* getTarget() const { return currentTarget; }
+    int getIndex() const { return index; }
+    double getX() const { return store->x[index]; }
+    double getY() const { return store->y[index]; }
+    void setX(double x) { store->x[index] = x; }
+    void setY(double y) { store->y[index] = y; }
+    double getAngle() const { return store->angle[index]; }
+    double getHealth() const { return store->health[index]; }
+    void setHealth(double h) { store->health[index] = h; }
+    double getHunger() const { return store->hunger[index]; }
+    int getState() const { return store->state[index]; }
+    double getRange() const { return store->detection_range[index]; }
+    int getId() const { return store->id[index]; }
+    double getSpeed() const { return store->current_speed[index]; }
+    int getSpecies() const { return store->species[index]; }
+    double getStealthLevel() const { return store->stealth_level[index]; }
+    double getDetectionSkill() const { return store->detection_skill[index]; }
+    void setAngle(double ang) { store->angle[index] = ang; }
+    double getFoodCapacity() const { return parameters().templates[getSpecies()].foodCapacity; }
+    double getCurrentStealth() const { return store->current_stealth[index]; }
+    bool isMale() const { return store->male[index]; }
+    bool isReadyToReproduce() const { return store->is_ready_to_reproduce[index]; }
+    AnimalHandle getTarget() const { return store->currentTarget[index]; }
 
     /*
         Bir hayvann dieriyle iftleebilmesi iin;
@@ -494,11 +1283,13 @@ public:
          - Biri erkek, dieri dii olmal
          - kisi de hamile olmamal (gebelik durumu yok)
     */
-    bool canMateWith(const Animal* other) const {
-        return (species == other->species)
-            && (male != other->male)
-            && (!isPregnant)
-            && (!other->isPregnant);
+    bool canMateWith(const Animal& other) const {
+        const AnimalStore& s = *store;
+        const AnimalStore& o = *other.store;
+        return (s.species[index] == o.species[other.index])
+            && (s.male[index] != o.male[other.index])
+            && (!s.isPregnant[index])
+            && (!o.isPregnant[other.index]);
     }
 
     /*
@@ -506,48 +1297,76 @@ public:
         sre sonunda ise yavrularn dourur (birthQueue'ya ekler).
     */
     void updatePregnancy() {
-        if (isPregnant) {
-            if (!statsReduced) {
+        AnimalStore& s = *store;
+        if (s.isPregnant[index]) {
+            double& speed_coefficient = s.speed_coefficient[index];
+            double& detection_range = s.detection_range[index];
+            double& stealth_level = s.stealth_level[index];
+            double& detection_skill = s.detection_skill[index];
+            int species = s.species[index];
+
+            if (!s.statsReduced[index]) {
                 // Gebeliin balangcnda hayvann baz deerlerini dr
                 speed_coefficient *= 0.8;
                 detection_range *= 0.8;
                 stealth_level *= 0.8;
                 detection_skill *= 0.8;
-                statsReduced = true;
+                s.statsReduced[index] = true;
             }
 
             // reproduction_cooldown sfra inince doum gerekleiyor.
-            if (reproduction_cooldown <= 0) {
+            if (s.reproduction_cooldown[index] <= 0) {
                 // Gebelik bittiinde deerleri geri ykle
                 speed_coefficient /= 0.8;
                 detection_range /= 0.8;
                 stealth_level /= 0.8;
                 detection_skill /= 0.8;
 
-                // Womb iinde yavrularn zellikleri sakl, oradan alnp doum kuyruuna ekleniyor.
-                int modulo = std::mt19937{ std::random_device{}() }() % maxBirthNum[species];
-                for (int i = 0; i < 1 + modulo; i++) {
-                    birthQueuePtr->enqueueBirth(
-                        species,
-                        Womb[0], Womb[1],
-                        Womb[2], Womb[3],
-                        Womb[4], Womb[5]
-                    );
-                }
-
-                cout << "Hayvan ID: " << getId() << " (tur: " << animalNames[species] << ") basarili sekilde dogum yapti.\n";
+                int modulo = rng().below(parameters().maxBirthNum[species]);
+                intent->births = 1 + modulo;
 
-                isPregnant = false;
-                reproduction_cooldown = 0;
-                statsReduced = false;
+                s.isPregnant[index] = false;
+                s.reproduction_cooldown[index] = 0;
+                s.statsReduced[index] = false;
             }
         }
     }
 
-    // Hayvan hareket ettiren basit fonksiyonlar
+    /*
+        giveBirth(), Womb iinde saklanan yavru zellikleriyle count adet doumu doum kuyruuna ekler.
+    */
+    void giveBirth(int count) {
+        AnimalStore& s = *store;
+        int species = s.species[index];
+        const std::array<double, 6>& Womb = s.Womb[index];
+        for (int i = 0; i < count; i++) {
+            s.birthQueuePtr->enqueueBirth(
+                species,
+                Womb[0], Womb[1],
+                Womb[2], Womb[3],
+                Womb[4], Womb[5]
+            );
+        }
+
+        if (logEvents) {
+            cout << "Hayvan ID: " << getId() << " (tur: " << parameters().names[species] << ") basarili sekilde dogum yapti.\n";
+        }
+    }
+
+    /*
+        moveForward(), hayvann bu admda gncel hzyla ileri gideceini kaydeder. Konum burada deimez:
+        Environment::moveAnimals() tm hayvanlar gncelleme aamasndan sonra tek geite ilerletir.
+        (Hayvan adm bana en fazla bir kez ilerler; ikinci ar yalnzca mesafeyi yeniler.)
+    */
     void moveForward() {
-        x_coordinate += cos(angle) * current_speed;
-        y_coordinate += sin(angle) * current_speed;
+        store->move_distance[index] = store->current_speed[index];
+    }
+
+    // normalizeAngle(), en fazla bir tam tur darda kalan ay [0, 2*PI) aralna getirir.
+    static double normalizeAngle(double angle) {
+        if (angle < 0) angle += 2 * PI;
+        if (angle >= 2 * PI) angle -= 2 * PI;
+        return angle;
     }
 
     /*
@@ -555,17 +1374,20 @@ public:
         last_change, bu deiiklii hatrlamak iin tutulur.
     */
     void turnRandomly() {
+        AnimalStore& s = *store;
+        double& angle = s.angle[index];
+        double& last_change = s.last_change[index];
+        double max_turn_rate = s.max_turn_rate[index];
+
         double p = (last_change > 0) ? 0.7 : (last_change < 0) ? 0.3 : 0.5;
-        double change = (bin_dist(10, p) - 5) / 180.0 * PI;
+        CounterRng random = rng();
+        double change = (bin_dist(10, p, random) - 5) / 180.0 * PI;
 
         if (change > max_turn_rate)  change = max_turn_rate;
         if (change < -max_turn_rate) change = -max_turn_rate;
 
-        angle += change;
+        angle = normalizeAngle(angle + change);
         last_change = change;
-
-        while (angle < 0)     angle += 2 * PI;
-        while (angle >= 2 * PI) angle -= 2 * PI;
     }
 
     /*
@@ -573,10 +1395,12 @@ public:
         yavaa (max_turn_rate'i amayacak ekilde) o yne dnmesini salar.
     */
     void turn(double ang) {
+        double& angle = store->angle[index];
+        double max_turn_rate = store->max_turn_rate[index];
+        // Alar [0, 2*PI) aralnda olduundan fark (-2*PI, 2*PI) iindedir; tek dzeltme yeterli
         double diff = ang - angle;
-
-        while (diff < -PI) diff += 2 * PI;
-        while (diff > PI)  diff -= 2 * PI;
+        if (diff < -PI) diff += 2 * PI;
+        else if (diff > PI) diff -= 2 * PI;
 
         if (fabs(diff) > max_turn_rate) {
             angle += (diff > 0 ? max_turn_rate : -max_turn_rate);
@@ -584,9 +1408,7 @@ public:
         else {
             angle = ang;
         }
-
-        while (angle < 0)       angle += 2 * PI;
-        while (angle >= 2 * PI) angle -= 2 * PI;
+        angle = normalizeAngle(angle);
     }
 
     /*
@@ -594,8 +1416,8 @@ public:
         yavaa dnerek ilerlemesini salar.
     */
     void moveTowards(double target_x, double target_y) {
-        double dx = target_x - x_coordinate;
-        double dy = target_y - y_coordinate;
+        double dx = target_x - getX();
+        double dy = target_y - getY();
         double target_angle = atan2(dy, dx);
 
         turn(target_angle);
@@ -606,8 +1428,8 @@ public:
         getDistance(), (target_x, target_y) noktasna olan uzakl dndrr.
     */
     double getDistance(double target_x, double target_y) const {
-        double dx = target_x - x_coordinate;
-        double dy = target_y - y_coordinate;
+        double dx = target_x - getX();
+        double dy = target_y - getY();
         return hypot(dx, dy);
     }
 
@@ -621,43 +1443,66 @@ public:
 
     // Alglama (Detection) fonksiyonlar
     bool isInDetectionZone(double x, double y) const {
-        double dx = x - x_coordinate;
-        double dy = y - y_coordinate;
+        double dx = x - getX();
+        double dy = y - getY();
         double distanceSquared = dx * dx + dy * dy;
+        double detection_range = getRange();
         return distanceSquared < (detection_range * detection_range);
     }
 
-    void addDetectedAnimal(Animal* animal) {
-        detectedAnimals.push_back(animal);
+    void addDetectedAnimal(int other) {
+        detectedAnimals().push_back(other);
     }
 
     /*
-        detectAnimals(), evrede bulunan hayvanlar listesinden,
+        detectAnimals(), evrede bulunan hayvanlar listesinden (depo indeksleri),
         bu hayvann alglama menzilinde olup olmadn kontrol eder.
         Ardndan, rastgelelik + uzaklk faktryle tespit gerekleip gereklemeyeceini belirler.
+        Adaylarn konum ve gizlilik deerleri SoA tamponlarna toplanr ve detectBatch() ekirdeiyle topluca ilenir.
     */
-    void detectAnimals(const std::vector<Animal*>& animalsInRange) {
-        detectedAnimals.clear();
-        for (Animal* other : animalsInRange) {
-            if (other != this) {
-                double distance = getDistance(other->getX(), other->getY());
+    void detectAnimals(const std::vector<int>& animalsInRange) {
+        const AnimalStore& s = *store;
+        std::vector<int>& detected = detectedAnimals();
+        DetectionScratch& scratch = detectionScratch();
+        CounterRng random = rng();
+
+        scratch.candidates.clear();
+        for (int other : animalsInRange) {
+            if (other != index) {
+                scratch.candidates.push_back(other);
+            }
+        }
+        size_t count = scratch.candidates.size();
+        detected.clear();
+        if (count == 0) {
+            return;
+        }
 
-                double kk = 0.65;
-                double probability_of_detection = (0.5 + this->detection_skill - other->getCurrentStealth()) * kk;
-                probability_of_detection *= exp(-distance / this->detection_range);
-                probability_of_detection = std::clamp(probability_of_detection, 0.0, 1.0);
+        scratch.x.resize(count);
+        scratch.y.resize(count);
+        scratch.stealth.resize(count);
+        scratch.rolls.resize(count);
+        scratch.detected.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            int other = scratch.candidates[k];
+            scratch.x[k] = s.x[other];
+            scratch.y[k] = s.y[other];
+            scratch.stealth[k] = s.current_stealth[other];
+        }
 
-                double randomRoll = rand() / static_cast<double>(RAND_MAX);
+        detectBatch(scratch.x.data(), scratch.y.data(), scratch.stealth.data(), static_cast<int>(count),
+            s.x[index], s.y[index], s.detection_skill[index], s.detection_range[index], random,
+            scratch.rolls.data(), scratch.detected.data());
 
-                if (randomRoll < probability_of_detection) {
-                    detectedAnimals.push_back(other);
-                }
+        for (size_t k = 0; k < count; k++) {
+            if (scratch.detected[k]) {
+                detected.push_back(scratch.candidates[k]);
             }
         }
     }
 
     void addDetectedEntity(Entity* entity) {
-        detectedEntities.push_back(entity);
+        detectedEntities().push_back(entity);
     }
 
     /*
@@ -665,7 +1510,7 @@ public:
         Alglama menzili iindeki Entity'leri detectedEntities'e ekler.
     */
     void detectEntities(const std::vector<Entity*>& entitiesInRange) {
-        detectedEntities.clear();
+        detectedEntities().clear();
         for (const auto& entity : entitiesInRange) {
             if (isInDetectionZone(entity->getX(), entity->getY())) {
                 addDetectedEntity(entity);
@@ -674,7 +1519,7 @@ public:
     }
 
     void addDetectedPlant(Plant* plant) {
-        detectedPlants.push_back(plant);
+        detectedPlants().push_back(plant);
     }
 
     /*
@@ -682,7 +1527,7 @@ public:
         Alglanan bitkiler detectedPlants vektrne eklenir.
     */
     void detectPlants(const std::vector<Plant*>& plantsInRange) {
-        detectedPlants.clear();
+        detectedPlants().clear();
         for (const auto& plant : plantsInRange) {
             if (isInDetectionZone(plant->getX(), plant->getY())) {
                 addDetectedPlant(plant);
@@ -694,8 +1539,12 @@ public:
         createOffspring(), iftleme sonucunda yavrularn genetik kombinasyonlarn (ve mutasyonlarn) hesaplar.
         Yavrular, dii hayvann hamile (isPregnant) kalmas ile doum kuyruuna eklenecektir.
     */
-    void createOffspring(Animal* partner) {
-        std::mt19937 generator(std::random_device{}());
+    void createOffspring(const Animal& partner) {
+        AnimalStore& s = *store;
+        int species = s.species[index];
+        int p = partner.index;
+
+        CounterRng generator = rng();
         std::uniform_real_distribution<double> distribution(-1.0, 1.0);
 
         double mutation_rate = 0.175;
@@ -710,40 +1559,108 @@ public:
             }
             };
 
-        double offspring_speed = mutate((speed_coefficient + partner->speed_coefficient) / 2,
-            animalLimitMax[species].speed,
-            animalLimitMin[species].speed);
-        double offspring_detection = (detection_range + partner->detection_range) / 2;
-        double offspring_stealth = mutate((stealth_level + partner->stealth_level) / 2,
-            animalLimitMax[species].stealthLevel,
-            animalLimitMin[species].stealthLevel);
-        double offspring_detection_skill = mutate((detection_skill + partner->detection_skill) / 2,
-            animalLimitMax[species].detectionSkill,
-            animalLimitMin[species].detectionSkill);
+        double offspring_speed = mutate((s.speed_coefficient[index] + s.speed_coefficient[p]) / 2,
+            parameters().limitMax[species].speed,
+            parameters().limitMin[species].speed);
+        double offspring_detection = (s.detection_range[index] + s.detection_range[p]) / 2;
+        double offspring_stealth = mutate((s.stealth_level[index] + s.stealth_level[p]) / 2,
+            parameters().limitMax[species].stealthLevel,
+            parameters().limitMin[species].stealthLevel);
+        double offspring_detection_skill = mutate((s.detection_skill[index] + s.detection_skill[p]) / 2,
+            parameters().limitMax[species].detectionSkill,
+            parameters().limitMin[species].detectionSkill);
 
-        double offspring_x = x_coordinate + (rand() % 10 - 5);
-        double offspring_y = y_coordinate + (rand() % 10 - 5);
+        double offspring_x = s.x[index] + (generator.below(10) - 5);
+        double offspring_y = s.y[index] + (generator.below(10) - 5);
 
         // Dii olan hamile kalr ve doum verileri Womb'a eklenir
-        if (!male) {
-            isPregnant = true;
-            Womb = { offspring_x, offspring_y, offspring_speed, offspring_detection, offspring_stealth, offspring_detection_skill };
+        int mother = s.male[index] ? p : index;
+        int father = s.male[index] ? index : p;
+
+        s.isPregnant[mother] = true;
+        s.Womb[mother] = { offspring_x, offspring_y, offspring_speed, offspring_detection, offspring_stealth, offspring_detection_skill };
 
-            reproduction_cooldown = animalTemplates[species].reproductionCooldown
-                + (std::mt19937{ std::random_device{}() }() % reproductionCooldownRandom[species]);
+        s.reproduction_cooldown[mother] = parameters().templates[species].reproductionCooldown
+            + generator.below(parameters().reproductionCooldownRandom[species]);
+
+        s.reproduction_cooldown[father] = parameters().templates[species].reproductionCooldown
+            + generator.below(parameters().reproductionCooldownRandom[species]);
+    }
 
-            partner->reproduction_cooldown = animalTemplates[species].reproductionCooldown
-                + (std::mt19937{ std::random_device{}() }() % reproductionCooldownRandom[species]);
+    /*
+        attack(), target indeksli hayvana saldrr; av lrse avc onun gda kapasitesi kadar doyar.
+        Paralel admda ayn ava birden fazla saldr kaydedilmi olabilir; av bu srada lmse saldr yaplmaz.
+    */
+    void attack(int targetIndex) {
+        AnimalStore& s = *store;
+        Animal target(store, targetIndex);
+        if (target.getHealth() <= 0) {
+            return;
+        }
+
+        target.setHealth(target.getHealth() - 300);
+        if (logEvents) {
+            cout << "Hayvan ID: " << target.getId() << ", tur: "
+                << parameters().names[target.getSpecies()]
+                << " saldiriyi aldi. Saldiran ID: " << getId()
+                << ", tur: " << parameters().names[getSpecies()] << "\n";
+        }
+
+        if (target.getHealth() <= 0) {
+            s.hunger[index] -= target.getFoodCapacity();
+        }
+    }
+
+    /*
+        eat(), bitkiden en fazla foodHungerDecrease (80) kadar yer; yenen miktarn yars alktan der.
+    */
+    void eat(Plant* plant) {
+        double foodHungerDecrease = 80;
+        double foodTaken = std::min(foodHungerDecrease, plant->getFood());
+        plant->setFood(plant->getFood() - foodTaken);
+        store->hunger[index] -= foodTaken / 2;
+    }
+
+    /*
+        mate(), partnerIndex'li hayvanla iftleir (yavru verileri createOffspring ile hesaplanr).
+        Paralel admda koullar uygulama annda yeniden kontrol edilir; partner bu arada bakasyla
+        iftlemise iftleme olmaz.
+    */
+    void mate(int partnerIndex) {
+        AnimalStore& s = *store;
+        Animal partner(store, partnerIndex);
+        if (!s.is_ready_to_reproduce[index] || !partner.isReadyToReproduce() || !canMateWith(partner)) {
+            return;
         }
-        else {
-            partner->isPregnant = true;
-            partner->Womb = { offspring_x, offspring_y, offspring_speed, offspring_detection, offspring_stealth, offspring_detection_skill };
 
-            partner->reproduction_cooldown = animalTemplates[species].reproductionCooldown
-                + (std::mt19937{ std::random_device{}() }() % reproductionCooldownRandom[species]);
+        createOffspring(partner);
+        s.is_ready_to_reproduce[index] = false;
+        s.is_ready_to_reproduce[partnerIndex] = false;
+
+        if (logEvents) {
+            cout << "Hayvan ID: " << getId() << " (" << parameters().names[getSpecies()]
+                << (isMale() ? ", Erkek" : ", Disi") << ") , ID: "
+                << partner.getId() << " (" << parameters().names[partner.getSpecies()]
+                << (partner.isMale() ? ", Erkek" : ", Disi")
+                << ") ile eslesti.\n\n";
+        }
+    }
 
-            reproduction_cooldown = animalTemplates[species].reproductionCooldown
-                + (std::mt19937{ std::random_device{}() }() % reproductionCooldownRandom[species]);
+    /*
+        applyIntent(), update() srasnda kaydedilen yazmalar uygular (tek i paracnda, hayvan srasyla arlr).
+    */
+    void applyIntent(const StepIntent& stepIntent) {
+        if (stepIntent.births > 0) {
+            giveBirth(stepIntent.births);
+        }
+        if (stepIntent.attackTarget != -1) {
+            attack(stepIntent.attackTarget);
+        }
+        if (stepIntent.plant) {
+            eat(stepIntent.plant);
+        }
+        if (stepIntent.mateWith != -1) {
+            mate(stepIntent.mateWith);
         }
     }
 
@@ -752,17 +1669,19 @@ public:
         Ya, death_time' aarsa hayvann saln 0 yapar.
     */
     void updateDeath() {
-        if (age >= death_time) {
+        AnimalStore& s = *store;
+        if (s.age[index] >= s.death_time[index]) {
             setHealth(0);
-            maxHealth = 0;
+            s.maxHealth[index] = 0;
         }
-        age++;
+        s.age[index]++;
     }
 
     /*
         updateReproduction(), reme bekleme sresini (cooldown) azaltr (her adm).
     */
     void updateReproduction() {
+        int& reproduction_cooldown = store->reproduction_cooldown[index];
         if (reproduction_cooldown > 0) {
             reproduction_cooldown--;
         }
@@ -773,10 +1692,11 @@ public:
         anlk gizlilik deerini (current_stealth) gnceller.
     */
     void updateStealthLevelBasedOnState() {
-        double base_stealth = stealth_level;
+        AnimalStore& s = *store;
+        double base_stealth = s.stealth_level[index];
         double adjustment = 0.0;
 
-        switch (state) {
+        switch (s.state[index]) {
         case Idle:
         case Wandering:
             adjustment = 0.1;
@@ -792,8 +1712,7 @@ public:
             break;
         }
 
-        current_stealth = base_stealth + adjustment;
-        current_stealth = std::clamp(current_stealth, 0.0, 0.5);
+        s.current_stealth[index] = std::clamp(base_stealth + adjustment, 0.0, 0.5);
     }
 
     /*
@@ -813,19 +1732,27 @@ public:
         hangi durumda (state) olmas gerektiine karar verir.
     */
     void updateState() {
+        AnimalStore& s = *store;
+        int& state = s.state[index];
+        char& is_ready_to_reproduce = s.is_ready_to_reproduce[index];
+        int species = s.species[index];
+        double hunger = s.hunger[index];
+        double maxHunger = s.maxHunger[index];
+
         state = Wandering;
         is_ready_to_reproduce = false;
 
         // Avc hayvan tespit edildiyse, "Flee" durumu
-        for (const auto& predator : detectedAnimals) {
-            if (foodChainMatrix[predator->getSpecies()][species] == 1 && predator->getState() == 2) {
+        const AnimalStore& r = *readStore;
+        for (int predator : detectedAnimals()) {
+            if (parameters().canEat(r.species[predator], species) && r.state[predator] == 2) {
                 state = Flee;
                 return;
             }
         }
 
         // remeye hazr olma koullar
-        if (hunger < maxHunger * 0.5 && health > maxHealth * 0.6) {
+        if (hunger < maxHunger * 0.5 && s.health[index] > s.maxHealth[index] * 0.6) {
             state = LookForPartner;
             is_ready_to_reproduce = true;
             return;
@@ -857,6 +1784,17 @@ public:
         updatePregnancy();
         updateStealthLevelBasedOnState();
 
+        AnimalStore& s = *store;
+        double& hunger = s.hunger[index];
+        double& health = s.health[index];
+        double& current_speed = s.current_speed[index];
+        AnimalHandle& currentTarget = s.currentTarget[index];
+        double maxHunger = s.maxHunger[index];
+        double maxHealth = s.maxHealth[index];
+        double speed_coefficient = s.speed_coefficient[index];
+        double detection_range = s.detection_range[index];
+        int species = s.species[index];
+
         // Baz sabitler (deneysel)
         double idleHealthGain = 0.5;
         double idleHungerIncrease = 0.015;
@@ -873,7 +1811,7 @@ public:
             health -= healthStarvationDecrease;
         }
 
-        switch (state) {
+        switch (s.state[index]) {
         case Idle:
             // Dinlenme: alk yava artar, salk biraz dzelir
             hunger += idleHungerIncrease / 2;
@@ -887,18 +1825,17 @@ public:
             break;
 
         case LookForFood: {
-            bool isHerbivore = foodChainMatrix[species][NUM_ANIMALS];
+            bool isHerbivore = parameters().isHerbivore(species);
             double eatRange = 1.0;
-            double foodHungerDecrease = 80;
 
             if (isHerbivore) {
                 // Otul hayvan bitki arar
-                if (!detectedPlants.empty()) {
+                if (!detectedPlants().empty()) {
                     Plant* bestPlant = nullptr;
                     double bestBenefit = 0.0;
 
                     // En iyi bitkiyi bul (fayda hesaplama)
-                    for (const auto& plant : detectedPlants) {
+                    for (const auto& plant : detectedPlants()) {
                         double distance = getDistance(plant->getX(), plant->getY());
                         double plantFood = plant->getFood();
                         double benefit = plantFood - (distance / current_speed * idleHungerIncrease);
@@ -912,9 +1849,7 @@ public:
                     // Elde en iyi bitki varsa, ona git ve ye
                     if (bestPlant) {
                         if (getDistance(bestPlant->getX(), bestPlant->getY()) <= eatRange) {
-                            double foodTaken = std::min(foodHungerDecrease, bestPlant->getFood());
-                            bestPlant->setFood(bestPlant->getFood() - foodTaken);
-                            hunger -= foodTaken / 2;
+                            intent->plant = bestPlant;
                         }
                         current_speed = speed_coefficient * idleSpeed * currentSpeedCoefficient;
                         moveTowards(bestPlant->getX(), bestPlant->getY());
@@ -933,66 +1868,58 @@ public:
                 health += idleHealthGain;
             }
             else {
-                // Etil hayvan av arar
-                if (!detectedAnimals.empty() || !currentTarget) {
-                    double bestBenefit = 0;
-                    double attackRange = 3;
-
-                    // Eer henz bir hedef yoksa, en iyi av se
-                    if (currentTarget == nullptr) {
-                        for (auto prey : detectedAnimals) {
-                            if (foodChainMatrix[species][prey->getSpecies()] == 1) {
-                                double distance = getDistance(prey->getX(), prey->getY());
-                                double preyFoodCapacity = prey->getFoodCapacity();
-                                double chaseCost = distance / current_speed * fightOrFleeHungerIncrease;
-                                double benefit = preyFoodCapacity - chaseCost;
-
-                                if (benefit > bestBenefit) {
-                                    bestBenefit = benefit;
-                                    currentTarget = prey;
-                                }
+                // Etil hayvan av arar. Hedef ldyse handle' geersizdir ve targetIndex -1 olur.
+                // Mevcut hedefin geerlilii (salk ve menzil) alglama listesinden bamsz olarak dorudan denetlenir.
+                int targetIndex = s.resolve(currentTarget);
+                double bestBenefit = 0;
+                double attackRange = 3;
+
+                // Eer henz bir hedef yoksa, en iyi av se
+                if (targetIndex == -1) {
+                    for (int preyIndex : detectedAnimals()) {
+                        Animal prey(readStore, preyIndex);
+                        if (parameters().canEat(species, prey.getSpecies())) {
+                            double distance = getDistance(prey.getX(), prey.getY());
+                            double preyFoodCapacity = prey.getFoodCapacity();
+                            double chaseCost = distance / current_speed * fightOrFleeHungerIncrease;
+                            double benefit = preyFoodCapacity - chaseCost;
+
+                            if (benefit > bestBenefit) {
+                                bestBenefit = benefit;
+                                targetIndex = preyIndex;
                             }
                         }
                     }
-                    // Hedef (currentTarget) lm veya menzil dna kmsa sfrla
-                    if (currentTarget) {
-                        if (currentTarget->getHealth() <= 0 || getDistance(currentTarget->getX(), currentTarget->getY()) > detection_range) {
-                            currentTarget = nullptr;
-                        }
+                }
+                // Hedef (currentTarget) lm veya menzil dna kmsa sfrla
+                if (targetIndex != -1) {
+                    Animal target(readStore, targetIndex);
+                    if (target.getHealth() <= 0 || getDistance(target.getX(), target.getY()) > detection_range) {
+                        targetIndex = -1;
                     }
-                    // Hedef hala uygun
-                    if (currentTarget) {
-                        double distToTarget = getDistance(currentTarget->getX(), currentTarget->getY());
-                        if (distToTarget <= attackRange) {
-                            // Saldr
-                            currentTarget->setHealth(currentTarget->getHealth() - 300);
-                            cout << "Hayvan ID: " << currentTarget->getId() << ", tur: "
-                                << animalNames[currentTarget->getSpecies()]
-                                << " saldiriyi aldi. Saldiran ID: " << id
-                                << ", tur: " << animalNames[species] << "\n";
-
-                            if (currentTarget->getHealth() <= 0) {
-                                hunger -= currentTarget->getFoodCapacity();
-                            }
-                        }
-                        else if (distToTarget <= detection_range) {
-                            // Hedefe doru ko
-                            current_speed = speed_coefficient * fightFlightSpeed * currentSpeedCoefficient;
-                            moveTowards(currentTarget->getX(), currentTarget->getY());
-                        }
-                        else {
-                            currentTarget = nullptr;
-                        }
+                }
+                // Hedef hala uygun
+                if (targetIndex != -1) {
+                    Animal target(readStore, targetIndex);
+                    double distToTarget = getDistance(target.getX(), target.getY());
+                    if (distToTarget <= attackRange) {
+                        // Saldr
+                        intent->attackTarget = targetIndex;
+                    }
+                    else if (distToTarget <= detection_range) {
+                        // Hedefe doru ko
+                        current_speed = speed_coefficient * fightFlightSpeed * currentSpeedCoefficient;
+                        moveTowards(target.getX(), target.getY());
                     }
                     else {
-                        current_speed = speed_coefficient * idleSpeed * currentSpeedCoefficient;
-                        moveRandomly();
+                        targetIndex = -1;
                     }
                 }
                 else {
                     current_speed = speed_coefficient * idleSpeed * currentSpeedCoefficient;
                     moveRandomly();
                 }
+                currentTarget = (targetIndex == -1) ? AnimalHandle() : s.handle(targetIndex);
                 hunger += idleHungerIncrease;
                 health += idleHealthGain;
             }
@@ -1000,20 +1927,21 @@ public:
         }
         case Flee:
             // Kama durumu
-            if (!detectedAnimals.empty()) {
+            if (!detectedAnimals().empty()) {
                 double totalWeightedX = 0.0;
                 double totalWeightedY = 0.0;
                 double totalWeight = 0.0;
 
-                for (const auto& predator : detectedAnimals) {
-                    if (foodChainMatrix[predator->getSpecies()][species] == 1) {
-                        double distance = getDistance(predator->getX(), predator->getY());
-                        double speed = predator->getSpeed();
+                for (int predatorIndex : detectedAnimals()) {
+                    Animal predator(readStore, predatorIndex);
+                    if (parameters().canEat(predator.getSpecies(), species)) {
+                        double distance = getDistance(predator.getX(), predator.getY());
+                        double speed = predator.getSpeed();
 
                         if (distance > 0) {
                             double weight = speed / distance;
-                            totalWeightedX += (predator->getX() * weight);
-                            totalWeightedY += (predator->getY() * weight);
+                            totalWeightedX += (predator.getX() * weight);
+                            totalWeightedY += (predator.getY() * weight);
                             totalWeight += weight;
                         }
                     }
@@ -1023,7 +1951,7 @@ public:
                     double averageX = totalWeightedX / totalWeight;
                     double averageY = totalWeightedY / totalWeight;
 
-                    double oppositeAngle = atan2(y_coordinate - averageY, x_coordinate - averageX);
+                    double oppositeAngle = atan2(getY() - averageY, getX() - averageX);
                     turn(oppositeAngle);
                     current_speed = speed_coefficient * fightFlightSpeed * currentSpeedCoefficient;
                     moveForward();
@@ -1046,37 +1974,30 @@ public:
 
         case LookForPartner: {
             // E aramak
-            int targetAnimalID = -1;
             double minDistance = std::numeric_limits<double>::max();
-            Animal* potentialPartner = nullptr;
-
-            for (auto other : detectedAnimals) {
-                if (other->species == species
-                    && other->is_ready_to_reproduce
-                    && reproduction_cooldown == 0
-                    && other != this
+            int potentialPartner = -1;
+
+            for (int otherIndex : detectedAnimals()) {
+                Animal other(readStore, otherIndex);
+                if (other.getSpecies() == species
+                    && other.isReadyToReproduce()
+                    && s.reproduction_cooldown[index] == 0
+                    && otherIndex != index
                     && canMateWith(other))
                 {
-                    double distance = getDistance(other->x_coordinate, other->y_coordinate);
+                    double distance = getDistance(other.getX(), other.getY());
                     if (distance < minDistance) {
                         minDistance = distance;
-                        potentialPartner = other;
+                        potentialPartner = otherIndex;
                     }
                 }
             }
 
-            if (potentialPartner) {
-                moveTowards(potentialPartner->getX(), potentialPartner->getY());
+            if (potentialPartner != -1) {
+                Animal partner(readStore, potentialPartner);
+                moveTowards(partner.getX(), partner.getY());
                 if (minDistance <= 3.0) {
-                    createOffspring(potentialPartner);
-                    is_ready_to_reproduce = false;
-                    potentialPartner->is_ready_to_reproduce = false;
-
-                    cout << "Hayvan ID: " << id << " (" << animalNames[species]
-                        << (male ? ", Erkek" : ", Disi") << ") , ID: "
-                        << potentialPartner->getId() << " (" << animalNames[potentialPartner->getSpecies()]
-                        << (potentialPartner->isMale() ? ", Erkek" : ", Disi")
-                        << ") ile eslesti.\n\n";
+                    intent->mateWith = potentialPartner;
                 }
             }
             else {
@@ -1093,59 +2014,492 @@ public:
     }
 
     /*
-        removeTarget(), currentTarget hedefi lmse veya baka bir nedenle
-        bu hayvandan karlmak istenirse arlr.
+        removeTarget(), currentTarget hedefi baka bir nedenle bu hayvandan karlmak istenirse arlr.
+        (len hedefler iin gerekmez; handle'lar kendiliinden geersiz olur.)
     */
-    void removeTarget(Animal* target) {
-        if (currentTarget == target) {
-            currentTarget = nullptr;
+    void removeTarget(AnimalHandle target) {
+        if (store->currentTarget[index] == target) {
+            store->currentTarget[index] = AnimalHandle();
         }
     }
 };
 
-/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
 /*
-    QuadTree veri yaps, 2B bir alan (width x height) dmlere blerek,
-    hayvan ve bitkilerin yerini hiyerarik olarak saklamak iin kullanlr.
-    Her dm (blge) 4 alt dme ayrlabilir.
-    Bylece belirli bir menzil iindeki varlklar daha hzl arayp bulmak mmkn olur.
+    AnimalStore::add(), yeni hayvann tm stunlarn doldurur.
+    (Animal::State tanmna ihtiya duyduu iin Animal snfndan sonra tanmlanmtr.)
 */
-class QuadTree {
+int AnimalStore::add(int id_, double x_, double y_, double speed, double detectionRange, int species_,
+    double stealth, double detection)
+{
+    // Balang deerleri hayvann doum akndan ekilir (ID ve kou tohumuyla tekrar retilebilir).
+    std::uint32_t birthDraws = 0;
+    CounterRng random{ seed, static_cast<std::uint32_t>(id_), RNG_BIRTH_DOMAIN, static_cast<std::uint64_t>(currentStep), birthDraws };
+
+    double maxHunger_ = 100;
+    double maxHealth_ = 100 + random.below(50);
+
+    id.push_back(id_);
+    x.push_back(x_);
+    y.push_back(y_);
+    angle.push_back(0);
+    last_change.push_back(0);
+    max_turn_rate.push_back(PI / 4);
+
+    speed_coefficient.push_back(speed);
+    current_speed.push_back(speed);
+    move_distance.push_back(0);
+    detection_range.push_back(detectionRange);
+    detection_skill.push_back(detection);
+    stealth_level.push_back(stealth);
+    current_stealth.push_back(stealth);
+
+    birth_speed.push_back(speed);
+    birth_stealth.push_back(stealth);
+    birth_detection.push_back(detection);
+
+    maxHunger.push_back(maxHunger_);
+    hunger.push_back(maxHunger_ * (0.2 + (random.below(100) / 100) * 0.6));
+    maxHealth.push_back(maxHealth_);
+    health.push_back(maxHealth_);
+    state.push_back(Animal::Idle);
+    species.push_back(species_);
+    age.push_back(0);
+    death_time.push_back(parameters->templates[species_].deathTime + random.below(parameters->deathTimeRandom[species_]));
+    aging_factor.push_back(parameters->agingFactor[species_]);
+    base_health_decay_rate.push_back(parameters->healthDecayRate[species_]);
+
+    reproduction_cooldown.push_back(parameters->templates[species_].reproductionCooldown
+        + random.below(parameters->reproductionCooldownRandom[species_]));
+    is_ready_to_reproduce.push_back(false);
+    male.push_back(random.below(2) == 0);
+    isPregnant.push_back(false);
+    statsReduced.push_back(false);
+    Womb.push_back({});
+
+    currentTarget.push_back(AnimalHandle());
+    detectedAnimals.emplace_back();
+    detectedEntities.emplace_back();
+    detectedPlants.emplace_back();
+
+    neighbours.emplace_back();
+    neighbourX.push_back(x_);
+    neighbourY.push_back(y_);
+    neighbourRange.push_back(-1);
+
+    int row = static_cast<int>(id.size()) - 1;
+    slot.push_back(allocateSlot(row));
+    tombstone.push_back(false);
+    rngDraws.push_back(0);
+    return row;
+}
+
+/*
+    AnimalStore::isConsistent() Animal'dan sonra tanmldr: durum deerleri Animal::State aralyla denetlenir.
+*/
+bool AnimalStore::isConsistent() {
+    size_t count = size();
+    bool consistent = true;
+    forEachColumn([&consistent, count](auto& column) {
+        consistent = consistent && column.size() == count;
+    });
+    if (!consistent || slotRow.size() != slotGeneration.size()) {
+        return false;
+    }
+    int slotCount = static_cast<int>(slotRow.size());
+    for (size_t i = 0; i < count; i++) {
+        if (slot[i] < 0 || slot[i] >= slotCount || slotRow[slot[i]] != static_cast<int>(i)) {
+            return false;
+        }
+        if (species[i] < 0 || species[i] >= NUM_ANIMALS || state[i] < Animal::Idle || state[i] > Animal::LookForPartner) {
+            return false;
+        }
+        // resolve() slot tablosunu snr denetimi yapmadan okur; zlen satr da depoda olmal
+        const AnimalHandle& target = currentTarget[i];
+        if (!target.isNull()) {
+            if (target.slot >= slotCount) {
+                return false;
+            }
+            int row = resolve(target);
+            if (row != -1 && (row < 0 || row >= static_cast<int>(count) || slot[row] != target.slot)) {
+                return false;
+            }
+        }
+        for (int other : detectedAnimals[i]) {
+            if (other < 0 || other >= static_cast<int>(count)) {
+                return false;
+            }
+        }
+        for (int other : neighbours[i]) {
+            if (other < 0 || other >= static_cast<int>(count)) {
+                return false;
+            }
+        }
+    }
+    for (int s : freeSlots) {
+        if (s < 0 || s >= slotCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    BinaryWriter ve BinaryReader, checkpoint dosyalarnn ikili okuma/yazma yardmclardr.
+    Diziler [uint64 eleman says][uint64 eleman boyu][veri] olarak yazlr ve veri 8 baytlk snra tamamlanr;
+    bylece her dizi dosyada hizal ve bitiik durur (dosya mmap ile alp diziler yerinde okunabilir).
+    Saylar makinenin yerel (little-endian) dzenindedir.
+*/
+class BinaryWriter {
+private:
+    std::ostream& stream;
+    std::uint64_t position;
+
+public:
+    explicit BinaryWriter(std::ostream& s) : stream(s), position(0) {}
+
+    void bytes(const void* data, size_t size) {
+        stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+
+    template <typename T>
+    void value(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "yalnizca bit bit kopyalanabilen tipler yazilabilir");
+        bytes(&v, sizeof(T));
+    }
+
+    void align() {
+        const char zeros[8] = {};
+        bytes(zeros, (8 - position % 8) % 8);
+    }
+
+    template <typename T>
+    void array(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "yalnizca bit bit kopyalanabilen tipler yazilabilir");
+        value(static_cast<std::uint64_t>(v.size()));
+        value(static_cast<std::uint64_t>(sizeof(T)));
+        bytes(v.data(), v.size() * sizeof(T));
+        align();
+    }
+
+    /*
+        ragged(), satr bana deiken uzunluklu listeleri (r. alglama listeleri) iki dizi olarak yazar:
+        satr balanglar (offsets, satr says + 1) ve toDisk ile int32'ye evrilmi dz deerler.
+    */
+    template <typename T, typename Convert>
+    void ragged(const std::vector<std::vector<T>>& rows, Convert toDisk) {
+        std::vector<std::uint64_t> offsets(1, 0);
+        std::vector<std::int32_t> values;
+        for (const auto& row : rows) {
+            for (const auto& item : row) {
+                values.push_back(toDisk(item));
+            }
+            offsets.push_back(values.size());
+        }
+        array(offsets);
+        array(values);
+    }
+
+    bool good() const { return static_cast<bool>(stream); }
+};
+
+class BinaryReader {
+private:
+    std::istream& stream;
+    std::uint64_t position;
+    std::uint64_t streamSize;   // Aktaki toplam bayt; dosyadan okunan saylar bununla snrlanr
+    bool failed;
+
+public:
+    BinaryReader(std::istream& s, std::uint64_t size) : stream(s), position(0), streamSize(size), failed(false) {}
+
+    void bytes(void* data, size_t size) {
+        if (failed || size > streamSize - position) {
+            failed = true;
+            return;
+        }
+        stream.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+        failed = !stream;
+    }
+
+    template <typename T>
+    void value(T& v) {
+        bytes(&v, sizeof(T));
+    }
+
+    void align() {
+        char skipped[8];
+        bytes(skipped, (8 - position % 8) % 8);
+    }
+
+    template <typename T>
+    void array(std::vector<T>& v) {
+        std::uint64_t count = 0, elementSize = 0;
+        value(count);
+        value(elementSize);
+        // Eleman says, bellek ayrlmadan nce akta kalan baytlarla snrlanr (bozuk balk dev bir ayrma yapamaz)
+        if (failed || elementSize != sizeof(T) || count > (streamSize - position) / sizeof(T)) {
+            failed = true;
+            return;
+        }
+        v.resize(count);
+        bytes(v.data(), count * sizeof(T));
+        align();
+    }
+
+    // ragged(), BinaryWriter::ragged() ile yazlan listeleri fromDisk ile asl tipe evirerek okur.
+    template <typename T, typename Convert>
+    void ragged(std::vector<std::vector<T>>& rows, Convert fromDisk) {
+        std::vector<std::uint64_t> offsets;
+        std::vector<std::int32_t> values;
+        array(offsets);
+        array(values);
+        if (failed || offsets.empty() || offsets.front() != 0 || offsets.back() != values.size()) {
+            failed = true;
+            return;
+        }
+        // Satr balanglar azalmamal; aksi halde aradaki bir deer values dn gsterebilir
+        for (size_t row = 0; row + 1 < offsets.size(); row++) {
+            if (offsets[row] > offsets[row + 1]) {
+                failed = true;
+                return;
+            }
+        }
+        rows.resize(offsets.size() - 1);
+        for (size_t row = 0; row + 1 < offsets.size(); row++) {
+            rows[row].clear();
+            for (std::uint64_t i = offsets[row]; i < offsets[row + 1]; i++) {
+                rows[row].push_back(fromDisk(values[i]));
+            }
+        }
+    }
+
+    void fail() { failed = true; }
+    bool good() const { return !failed; }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    SpatialIndex, hayvanlar (AnimalStore indeksleri) ve Entity'leri blgesel olarak saklayan
+    yaplar iin ortak arayzdr. Environment, hangi yapnn kullanlacan alma zamannda seer
+    (QuadTree veya UniformGrid).
+*/
+class SpatialIndex {
+public:
+    virtual ~SpatialIndex() {}
+
+    // Tm veriyi temizler.
+    virtual void clear() = 0;
+
+    virtual void insertAnimal(int animal) = 0;
+    virtual void insertEntity(Entity* entity) = 0;
+
+    /*
+        rebuild(), indeksi depodaki ilk animalCount hayvan ve verilen entity'lerle batan kurar.
+        Varsaylan uygulama hepsini tek tek ekler; toplu kurulum yapabilen yaplar bunu ezebilir.
+    */
+    virtual void rebuild(int animalCount, const std::vector<Entity*>& entities) {
+        clear();
+        for (int index = 0; index < animalCount; index++) {
+            insertAnimal(index);
+        }
+        for (auto& entity : entities) {
+            insertEntity(entity);
+        }
+    }
+
+    /*
+        update(), hayvanlar hareket ettikten sonra her admda arlr ve indeksi gncel konumlara getirir.
+        Varsaylan uygulama batan kurar (rebuild); artml yaplar yalnzca deien ksm gnceller.
+    */
+    virtual void update(int animalCount, const std::vector<Entity*>& entities) {
+        rebuild(animalCount, entities);
+    }
+
+    /*
+        compactAnimals(), AnimalStore::compact() sonrasnda arlr; newIndex[eski indeks] hayvann
+        yeni indeksidir (ldyse -1). Her admda batan kurulan yaplar iin bir ey yapmaya gerek yoktur.
+    */
+    virtual void compactAnimals(const std::vector<int>& /*newIndex*/) {}
+
+    /*
+        retrieveAnimal() ve retrieveEntity(), sonular arann verdii tampona (out) ekler; out temizlenmez.
+        Ayn tampon her sorguda yeniden kullanldnda sorgu bana bellek ayrma yaplmaz.
+        speciesMask verilirse yalnzca tr maskede olan hayvanlar dner (bit i = tr i); sonu, tm trlerle
+        yaplan sorgunun ayn srayla szlm hlidir.
+    */
+    virtual void retrieveAnimal(int self, double objX, double objY, double range, std::uint32_t speciesMask,
+        std::vector<int>& out) = 0;
+    virtual void retrieveEntity(double objX, double objY, double range, std::vector<Entity*>& out) = 0;
+
+    void retrieveAnimal(int self, double objX, double objY, double range, std::vector<int>& out) {
+        retrieveAnimal(self, objX, objY, range, ALL_SPECIES_MASK, out);
+    }
+
+    // Sonucu yeni bir vektr olarak dndren kolaylk srmleri (scak dnglerde tampon srm tercih edilmeli).
+    std::vector<int> retrieveAnimal(int self, double objX, double objY, double range) {
+        std::vector<int> result;
+        retrieveAnimal(self, objX, objY, range, result);
+        return result;
+    }
+
+    std::vector<Entity*> retrieveEntity(double objX, double objY, double range) {
+        std::vector<Entity*> result;
+        retrieveEntity(objX, objY, range, result);
+        return result;
+    }
+
+    // exportIndex(), yapnn o anki geometrisini JSON olarak dar aktarr (grselletirme iin).
+    virtual void exportIndex(json& frame_data) const = 0;
+    /*
+        saveState() ve loadState(), checkpoint iin yapnn gemie bal durumunu yazar/okur.
+        Her admda batan kurulan yaplarn saklanacak durumu yoktur (false dner); yklemeden sonra rebuild() yeterlidir.
+        loadState() false dnerse aran yapy rebuild() ile kurmaldr.
+    */
+    virtual bool saveState(BinaryWriter& /*out*/) const { return false; }
+    virtual bool loadState(BinaryReader& /*in*/, int /*animalCount*/) { return false; }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    QuadTree veri yaps, 2B bir alan (width x height) dmlere blerek,
+    hayvan ve bitkilerin yerini hiyerarik olarak saklamak iin kullanlr.
+    Her dm (blge) 4 alt dme ayrlabilir.
+    Bylece belirli bir menzil iindeki varlklar daha hzl arayp bulmak mmkn olur.
+
+    Dmler tek bir dz havuzda (pool) tutulur:
+     - Bir dmn 4 ocuu havuzda art arda durur; dm yalnzca ilk ocuun indeksini (firstChild) saklar.
+     - split() new ile bellek ayrmaz, havuzun sonundan 4'l bir blok alr. clear() havuzu geri sarar (O(1));
+       dmlerin vektrleri kapasiteleriyle birlikte sonraki kurulumda yeniden kullanlr.
+     - Tm aa zerinde gezinmek (indeks kaydrma, da aktarma) havuz zerinde dorusal bir taramadr.
+
+    Artml (incremental) modda aa her admda silinip yeniden kurulmaz:
+     - Her hayvann bulunduu yaprak (leafTable) tutulur; yaprandan kmayan hayvana dokunulmaz.
+     - Yaprandan kan hayvan oradan silinir ve konumunu kapsayan en yakn ata dmden yeniden eklenir.
+     - Nesne says MERGE_OBJECTS'e inen dmlerin alt dmleri adm sonunda (tembel) birletirilir;
+       boalan 4'l bloklar freeBlocks listesine alnp sonraki blmelerde kullanlr.
+     - Bitkiler (entity'ler) yalnzca listeleri deitiinde yeniden eklenir.
+*/
+class QuadTree : public SpatialIndex {
 private:
     static const int MAX_OBJECTS = 5;
     static const int MAX_LEVELS = 6;
+    static const int MERGE_OBJECTS = MAX_OBJECTS / 2;  // Blme/birletirme salnmn nlemek iin daha dk eik
+    static constexpr int ROOT = 0;                     // Kk dmn havuz indeksi
+
+    struct Node {
+        int level;
+        double x, y, width, height;
+        int parent;                     // Kk iin -1
+        int firstChild;                 // Yaprak iin -1; aksi halde ocuklar firstChild..firstChild+3
+        bool mergePending;              // Birletirme kuyruunda m?
+        std::vector<int> animals;       // Bu dmdeki hayvanlarn depo indeksleri
+        std::vector<Entity*> entities;
+    };
 
-    int level;
-    std::vector<Animal*> animals;
-    std::vector<Entity*> entities;
+    const AnimalStore* animalStore;     // Hayvan konumlarnn okunduu SoA deposu
+    std::vector<Node> pool;             // Dm havuzu; pool[ROOT] kk dmdr
+    int nodeCount;                      // Havuzda kullanlan dm says (sonras yeniden kullanlmay bekler)
+    std::vector<int> freeBlocks;        // Birletirmede boalan 4'l bloklarn ilk indeksleri
+
+    // Artml mod verileri
+    bool incremental;
+    std::vector<int> leafTable;                     // Hayvan indeksi -> bulunduu yapran havuz indeksi
+    std::vector<std::vector<int>> mergeQueue;       // Seviyeye gre birletirme adaylar
+    size_t insertedEntityCount;
+
+    // resetNode(), havuzdaki bir dm verilen blge iin hazrlar (vektr kapasiteleri korunur).
+    void resetNode(int node, int lvl, int parentNode, double xCoord, double yCoord, double w, double h) {
+        Node& n = pool[node];
+        n.level = lvl;
+        n.x = xCoord;
+        n.y = yCoord;
+        n.width = w;
+        n.height = h;
+        n.parent = parentNode;
+        n.firstChild = -1;
+        n.mergePending = false;
+        n.animals.clear();
+        n.entities.clear();
+    }
+
+    // allocateBlock(), 4 karde dm iin havuzdan art arda bir blok alr ve ilk indeksini dndrr.
+    int allocateBlock() {
+        if (!freeBlocks.empty()) {
+            int block = freeBlocks.back();
+            freeBlocks.pop_back();
+            return block;
+        }
+        int block = nodeCount;
+        nodeCount += 4;
+        if (nodeCount > static_cast<int>(pool.size())) {
+            pool.resize(nodeCount);
+        }
+        return block;
+    }
 
-    QuadTree* nodes[4];
-    double x, y, width, height;
+    // recordLeaf(), artml modda hayvann hangi yaprakta durduunu tabloya yazar.
+    void recordLeaf(int animal, int node) {
+        if (!incremental) {
+            return;
+        }
+        if (animal >= static_cast<int>(leafTable.size())) {
+            leafTable.resize(animal + 1, -1);
+        }
+        leafTable[animal] = node;
+    }
 
     /*
         split(), Quadtree dmn 4 alt dme blerek,
         her bir alt dmn boyutlarn hesaplar.
+        Blnen dmde kalan hayvan ve entity'ler de alt dmlere datlr; aksi halde
+        (r. entity'ler yznden blnen bir dmdeki hayvanlar) sorgularda grnmez olurlar.
     */
-    void split() {
-        double subWidth = width / 2.0;
-        double subHeight = height / 2.0;
-        double xMid = x + subWidth;
-        double yMid = y + subHeight;
+    void split(int node) {
+        int first = allocateBlock();    // Havuz byyebilir; pool referanslar bundan sonra alnmal
+
+        Node& n = pool[node];
+        int lvl = n.level + 1;
+        double subWidth = n.width / 2.0;
+        double subHeight = n.height / 2.0;
+        double xMid = n.x + subWidth;
+        double yMid = n.y + subHeight;
+
+        resetNode(first + 0, lvl, node, n.x, n.y, subWidth, subHeight);
+        resetNode(first + 1, lvl, node, xMid, n.y, subWidth, subHeight);
+        resetNode(first + 2, lvl, node, n.x, yMid, subWidth, subHeight);
+        resetNode(first + 3, lvl, node, xMid, yMid, subWidth, subHeight);
+        n.firstChild = first;
+
+        // Alt dmler de blnebilir (havuz byyebilir); bu yzden n referans aada kullanlmaz.
+        std::vector<int> movedAnimals;
+        std::vector<Entity*> movedEntities;
+        movedAnimals.swap(n.animals);
+        movedEntities.swap(n.entities);
+        for (int animal : movedAnimals) {
+            insertAnimalAt(childFor(node, animalStore->x[animal], animalStore->y[animal]), animal);
+        }
+        for (Entity* entity : movedEntities) {
+            insertEntityAt(childFor(node, entity->getX(), entity->getY()), entity);
+        }
 
-        nodes[0] = new QuadTree(level + 1, x, y, subWidth, subHeight);
-        nodes[1] = new QuadTree(level + 1, xMid, y, subWidth, subHeight);
-        nodes[2] = new QuadTree(level + 1, x, yMid, subWidth, subHeight);
-        nodes[3] = new QuadTree(level + 1, xMid, yMid, subWidth, subHeight);
+        // Boalan vektrleri geri ver ki kapasiteleri bir sonraki kurulumda kullanlabilsin.
+        movedAnimals.clear();
+        movedEntities.clear();
+        pool[node].animals.swap(movedAnimals);
+        pool[node].entities.swap(movedEntities);
     }
 
     /*
         getIndex(), gnderilen (objX, objY) nesnesinin hangi alt dme
         (0: sol st, 1: sa st, 2: sol alt, 3: sa alt) ait olduunu dndrr.
     */
-    int getIndex(double objX, double objY) const {
+    int getIndex(const Node& n, double objX, double objY) const {
         int index = -1;
-        double verticalMidpoint = x + width / 2.0;
-        double horizontalMidpoint = y + height / 2.0;
+        double verticalMidpoint = n.x + n.width / 2.0;
+        double horizontalMidpoint = n.y + n.height / 2.0;
 
         bool topQuadrant = (objY < horizontalMidpoint);
         bool bottomQuadrant = (objY >= horizontalMidpoint);
@@ -1162,262 +2516,1944 @@ private:
         return index;
     }
 
+    // childFor(), (objX, objY) noktasnn decei alt dmn havuz indeksini dndrr.
+    int childFor(int node, double objX, double objY) const {
+        const Node& n = pool[node];
+        return n.firstChild + getIndex(n, objX, objY);
+    }
+
     /*
         isWithinRange(), (objX, objY) merkezli bir dairenin (range yarapl),
-        bu QuadTree dm ile kesiip kesimediini kontrol eder.
+        verilen QuadTree dm ile kesiip kesimediini kontrol eder.
     */
-    bool isWithinRange(double objX, double objY, double range) const {
-        double circleDistX = std::abs(objX - (x + width / 2.0));
-        double circleDistY = std::abs(objY - (y + height / 2.0));
+    static bool isWithinRange(const Node& n, double objX, double objY, double range) {
+        double circleDistX = std::abs(objX - (n.x + n.width / 2.0));
+        double circleDistY = std::abs(objY - (n.y + n.height / 2.0));
 
-        if (circleDistX > (width / 2.0 + range))  return false;
-        if (circleDistY > (height / 2.0 + range)) return false;
+        if (circleDistX > (n.width / 2.0 + range))  return false;
+        if (circleDistY > (n.height / 2.0 + range)) return false;
 
-        if (circleDistX <= (width / 2.0)) return true;
-        if (circleDistY <= (height / 2.0)) return true;
+        if (circleDistX <= (n.width / 2.0)) return true;
+        if (circleDistY <= (n.height / 2.0)) return true;
 
-        double cornerDistSq = std::pow(circleDistX - width / 2.0, 2)
-            + std::pow(circleDistY - height / 2.0, 2);
+        double cornerDistSq = std::pow(circleDistX - n.width / 2.0, 2)
+            + std::pow(circleDistY - n.height / 2.0, 2);
         return (cornerDistSq <= std::pow(range, 2));
     }
 
-public:
     /*
-        QuadTree kurucusu (constructor), seviye (lvl), x,y konumu, genilik ve ykseklik bilgisi alr.
-        nodes dizisi balangta bo (nullptr).
+        ownsPoint(), (objX, objY) noktas kkten balayan yerletirmede bu dme inerse true dndrr.
+        Snrlar iindeki noktalar iin hzl kontrol yeterlidir; alan dna tam noktalar
+        (henz sarlmam konumlar) kenar dmlere dt iin ini yolu yukardan dorulanr.
     */
-    QuadTree(int lvl, double xCoord, double yCoord, double w, double h)
-        : level(lvl), x(xCoord), y(yCoord), width(w), height(h)
-    {
-        for (int i = 0; i < 4; ++i) {
-            nodes[i] = nullptr;
+    bool ownsPoint(int node, double objX, double objY) const {
+        while (true) {
+            const Node& n = pool[node];
+            if (objX >= n.x && objX < n.x + n.width && objY >= n.y && objY < n.y + n.height) {
+                return true;
+            }
+            if (n.parent < 0) {
+                return true;
+            }
+            if (childFor(n.parent, objX, objY) != node) {
+                return false;
+            }
+            node = n.parent;
         }
     }
 
-    ~QuadTree() {
-        clear();
+    // eraseAnimal(), hayvan yapran listesinden karr (sra nemli deil).
+    void eraseAnimal(int node, int animal) {
+        std::vector<int>& animals = pool[node].animals;
+        auto it = std::find(animals.begin(), animals.end(), animal);
+        if (it != animals.end()) {
+            *it = animals.back();
+            animals.pop_back();
+        }
     }
 
-    // Tm veriyi temizler, alt dmleri siler.
-    void clear() {
-        animals.clear();
-        for (int i = 0; i < 4; ++i) {
-            if (nodes[i]) {
-                nodes[i]->clear();
-                delete nodes[i];
-                nodes[i] = nullptr;
-            }
+    // queueMerge(), dm adm sonunda birletirme denemesi iin kuyrua alr.
+    void queueMerge(int node) {
+        if (node >= 0 && !pool[node].mergePending) {
+            pool[node].mergePending = true;
+            mergeQueue[pool[node].level].push_back(node);
         }
     }
 
     /*
-        exportQuadTree(), Quadtree yapsn JSON formatnda dar aktarr.
-        Mevcut dm bilgilerini kaydeder, sonra varsa alt dmleri iin ayn ilemi uygular (rekrsif).
+        tryMerge(), tm alt dmleri yaprak olan ve toplam nesne says MERGE_OBJECTS'i amayan
+        bir dmn ocuklarn kendisine tar ve blou havuza geri verir. Birleme olursa true dndrr.
     */
-    void exportQuadTree(json& frame_data) const {
-        json node_data;
-        node_data["x"] = x;
-        node_data["y"] = y;
-        node_data["width"] = width;
-        node_data["height"] = height;
-        node_data["level"] = level;
-
+    bool tryMerge(int node) {
+        int first = pool[node].firstChild;
+        if (first < 0) {
+            return false;
+        }
+        size_t count = pool[node].animals.size() + pool[node].entities.size();
         for (int i = 0; i < 4; ++i) {
-            if (nodes[i]) {
-                json child_data;
-                nodes[i]->exportQuadTree(child_data);
-                node_data["children"].push_back(child_data);
+            const Node& child = pool[first + i];
+            if (child.firstChild >= 0) {
+                return false;
             }
+            count += child.animals.size() + child.entities.size();
+        }
+        if (count > MERGE_OBJECTS) {
+            return false;
         }
-        frame_data.push_back(node_data);
-    }
 
-    /*
-        insertAnimal(), hayvan bu Quadtree dmnn alt dmlerine yerletirmeye alr.
-        Eer sarsa dme ekler, nesneler ok fazla ise split() yapar.
-    */
-    void insertAnimal(Animal* animal) {
-        if (nodes[0]) {
-            int index = getIndex(animal->getX(), animal->getY());
-            if (index != -1) {
-                nodes[index]->insertAnimal(animal);
-                return;
+        Node& n = pool[node];
+        for (int i = 0; i < 4; ++i) {
+            Node& child = pool[first + i];
+            for (int animal : child.animals) {
+                n.animals.push_back(animal);
+                recordLeaf(animal, node);
             }
+            n.entities.insert(n.entities.end(), child.entities.begin(), child.entities.end());
+            child.animals.clear();
+            child.entities.clear();
+            child.firstChild = -1;
         }
+        n.firstChild = -1;
+        freeBlocks.push_back(first);
+        return true;
+    }
 
-        animals.push_back(animal);
-
-        if (animals.size() > MAX_OBJECTS && level < MAX_LEVELS) {
-            if (!nodes[0]) {
-                split();
-            }
-            auto it = animals.begin();
-            while (it != animals.end()) {
-                int index = getIndex((*it)->getX(), (*it)->getY());
-                if (index != -1) {
-                    nodes[index]->insertAnimal(*it);
-                    it = animals.erase(it);
-                }
-                else {
-                    ++it;
+    // processMerges(), kuyruktaki adaylar en derin seviyeden balayarak birletirir (zincirleme yukar doru).
+    void processMerges() {
+        for (int lvl = MAX_LEVELS; lvl >= 0; lvl--) {
+            for (int node : mergeQueue[lvl]) {
+                pool[node].mergePending = false;
+                if (tryMerge(node)) {
+                    queueMerge(pool[node].parent);
                 }
             }
+            mergeQueue[lvl].clear();
         }
     }
 
     /*
-        insertEntity(), Entity tipindeki varlklar (bitki vb.) quadtree'ye yerletirme fonksiyonu.
+        insertAnimalAt(), depo indeksi verilen hayvan node dmnden balayarak uygun yapraa yerletirir.
+        Yaprakta nesneler ok fazla ise split() yapar.
     */
-    void insertEntity(Entity* entity) {
-        if (nodes[0]) {
-            int index = getIndex(entity->getX(), entity->getY());
-            if (index != -1) {
-                nodes[index]->insertEntity(entity);
-                return;
-            }
+    void insertAnimalAt(int node, int animal) {
+        double objX = animalStore->x[animal];
+        double objY = animalStore->y[animal];
+        while (pool[node].firstChild >= 0) {
+            node = childFor(node, objX, objY);
         }
 
-        entities.push_back(entity);
-
-        if (entities.size() > MAX_OBJECTS && level < MAX_LEVELS) {
-            if (!nodes[0]) {
-                split();
-            }
+        Node& n = pool[node];
+        n.animals.push_back(animal);
+        recordLeaf(animal, node);
 
-            auto it = entities.begin();
-            while (it != entities.end()) {
-                int index = getIndex((*it)->getX(), (*it)->getY());
-                if (index != -1) {
-                    nodes[index]->insertEntity(*it);
-                    it = entities.erase(it);
-                }
-                else {
-                    ++it;
-                }
-            }
+        if (n.animals.size() > MAX_OBJECTS && n.level < MAX_LEVELS) {
+            split(node);
         }
     }
 
     /*
-        retrieveAnimal(), (objX, objY) ve range deerine gre
-        menzil iindeki hayvanlar dndrr.
+        insertEntityAt(), Entity tipindeki varlklar (bitki vb.) node dmnden balayarak yerletirir.
     */
-    std::vector<Animal*> retrieveAnimal(Animal* self, double objX, double objY, double range) {
-        std::vector<Animal*> result;
-
-        if (nodes[0]) {
-            for (int i = 0; i < 4; i++) {
-                if (nodes[i]->isWithinRange(objX, objY, range)) {
-                    std::vector<Animal*> retrieved = nodes[i]->retrieveAnimal(self, objX, objY, range);
-                    result.insert(result.end(), retrieved.begin(), retrieved.end());
-                }
-            }
+    void insertEntityAt(int node, Entity* entity) {
+        while (pool[node].firstChild >= 0) {
+            node = childFor(node, entity->getX(), entity->getY());
         }
-        else {
-            for (const auto& animal : animals) {
-                if (animal != self && std::hypot(animal->getX() - objX, animal->getY() - objY) <= range) {
-                    result.push_back(animal);
-                }
-            }
+
+        Node& n = pool[node];
+        n.entities.push_back(entity);
+
+        if (n.entities.size() > MAX_OBJECTS && n.level < MAX_LEVELS) {
+            split(node);
         }
-        return result;
     }
 
+public:
     /*
-        retrieveEntity(), ayn ekilde (objX, objY) ve range'e gre
-        menzil iindeki Entity'leri dndrr (Bitkiler dahil).
+        QuadTree kurucusu (constructor), kk seviyesi (lvl), x,y konumu, genilik ve ykseklik bilgisi alr.
+        store, hayvan indekslerinin konumlarn okumak iin kullanlan AnimalStore'dur.
+        Havuz balangta yalnzca kk dm ierir.
     */
-    std::vector<Entity*> retrieveEntity(double objX, double objY, double range) {
-        std::vector<Entity*> result;
-
-        if (nodes[0]) {
-            for (int i = 0; i < 4; i++) {
-                if (nodes[i]->isWithinRange(objX, objY, range)) {
-                    std::vector<Entity*> retrieved = nodes[i]->retrieveEntity(objX, objY, range);
-                    result.insert(result.end(), retrieved.begin(), retrieved.end());
-                }
-            }
-        }
-        else {
-            for (const auto& entity : entities) {
-                if (std::hypot(entity->getX() - objX, entity->getY() - objY) <= range) {
-                    result.push_back(entity);
-                }
-            }
+    QuadTree(int lvl, double xCoord, double yCoord, double w, double h, const AnimalStore* store,
+        bool incrementalMode = false)
+        : animalStore(store), pool(1), nodeCount(1), incremental(incrementalMode), insertedEntityCount(0)
+    {
+        resetNode(ROOT, lvl, -1, xCoord, yCoord, w, h);
+        if (incremental) {
+            mergeQueue.resize(MAX_LEVELS + 1);
         }
-        return result;
     }
-};
-
-/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
-/*
-    Environment, tm hayvanlar, bitkileri, quadtree yapsn ve simlasyon dngsn yneten snftr.
-    - addAnimal() ve addEntity() fonksiyonlar ile ekleme yaplr.
-    - update() fonksiyonu, her admda hayvanlarn ve bitkilerin durumunu gnceller.
-    - processBirthQueue() ile doum kuyruundaki yeni hayvanlar eklenir.
-    - Veriler JSON formatnda dosyaya kaydedilebilir.
-*/
-class Environment {
-private:
-    QuadTree* quadtree;
-    int width;
-    int height;
 
-public:
-    std::vector<Animal*> animals;
-    std::vector<Entity*> entities;
+    // Tm veriyi temizler: havuz kk dme geri sarlr (O(1)), dm bellei serbest braklmaz.
+    void clear() override {
+        Node& root = pool[ROOT];
+        resetNode(ROOT, root.level, -1, root.x, root.y, root.width, root.height);
+        nodeCount = 1;
+        freeBlocks.clear();
+        leafTable.clear();
+        for (auto& queue : mergeQueue) {
+            queue.clear();
+        }
+        insertedEntityCount = 0;
+    }
 
-    // Hayvanlarn zaman iinde konum kaytlar
-    std::map<int, std::vector<std::pair<double, double>>> animalPositions;
+    void rebuild(int animalCount, const std::vector<Entity*>& entityList) override {
+        SpatialIndex::rebuild(animalCount, entityList);
+        insertedEntityCount = entityList.size();
+    }
 
-    int lastAnimalID = 0;
-    BirthQueue birthQueue;
+    /*
+        update(), artml modda yalnzca yaprandan kan hayvanlar yeniden yerletirir,
+        yeni doanlar ekler ve boalan dmleri birletirir. Artml mod kapalysa
+        veya entity listesi deitiyse aa batan kurulur.
+    */
+    void update(int animalCount, const std::vector<Entity*>& entityList) override {
+        if (!incremental || entityList.size() != insertedEntityCount
+            || static_cast<int>(leafTable.size()) > animalCount)
+        {
+            rebuild(animalCount, entityList);
+            return;
+        }
 
-    Environment(int w, int h) : width(w), height(h) {
-        quadtree = new QuadTree(0, 0, 0, w, h);
-    }
+        int knownCount = static_cast<int>(leafTable.size());
+        for (int index = 0; index < knownCount; index++) {
+            int leaf = leafTable[index];
+            double objX = animalStore->x[index];
+            double objY = animalStore->y[index];
+            if (ownsPoint(leaf, objX, objY)) {
+                continue;
+            }
 
-    ~Environment() {
-        for (auto& animal : animals) {
-            delete animal;
+            // Yerel silme/yeniden ekleme: konumu kapsayan en yakn atadan aa doru yerletir.
+            eraseAnimal(leaf, index);
+            int node = pool[leaf].parent;
+            queueMerge(node);
+            while (pool[node].parent >= 0 && !ownsPoint(node, objX, objY)) {
+                node = pool[node].parent;
+            }
+            insertAnimalAt(node, index);
         }
-        for (auto& entity : entities) {
-            delete entity;
+
+        // Bu admda doan hayvanlar depo sonuna eklenmitir.
+        for (int index = knownCount; index < animalCount; index++) {
+            insertAnimal(index);
         }
-        delete quadtree;
-    }
 
-    /*
-        addAnimal(), hayvan ortama ekler, hayvanPositions iin ID'ye uygun kayt aar.
-    */
-    void addAnimal(Animal* animal) {
-        animalPositions[animal->getId()] = {};
-        animals.push_back(animal);
-        lastAnimalID++;
+        processMerges();
     }
 
     /*
-        removeAnimal(), ortamdan bir hayvan gvenli ekilde karr.
+        compactAnimals(), artml modda len hayvanlar yapraklarndan siler ve kalanlarn indekslerini
+        depodaki sktrmaya gre gnceller. lm saysndan bamsz olarak havuz zerinde tek bir
+        dorusal taramadr; hayvan kaybeden yapraklarn ebeveynleri birletirme iin kuyrua alnr.
     */
-    void removeAnimal(Animal* animalToRemove) {
-        animals.erase(std::remove(animals.begin(), animals.end(), animalToRemove), animals.end());
+    void compactAnimals(const std::vector<int>& newIndex) override {
+        if (!incremental) {
+            return;
+        }
+        for (int node = 0; node < nodeCount; node++) {
+            std::vector<int>& animals = pool[node].animals;
+            size_t kept = 0;
+            for (int animal : animals) {
+                if (newIndex[animal] >= 0) {
+                    animals[kept++] = newIndex[animal];
+                }
+            }
+            if (kept != animals.size()) {
+                animals.resize(kept);
+                queueMerge(pool[node].parent);
+            }
+        }
+
+        // Aataki hayvanlar deponun bandaki satrlardr; sktrma sray koruduu iin yine yle kalr.
+        size_t known = 0;
+        for (size_t index = 0; index < leafTable.size(); index++) {
+            if (newIndex[index] >= 0) {
+                leafTable[known++] = leafTable[index];
+            }
+        }
+        leafTable.resize(known);
     }
 
     /*
-        addEntity(), bitki vb. Entity tiplerini ortama ekler.
+        saveState(), artml aacn havuzunu (kullanlan dmler), bo bloklar, yaprak tablosunu ve birletirme
+        kuyruunu yazar. Aa her adm batan kuruluyorsa saklanacak bir ey yoktur.
     */
-    void addEntity(Entity* entity) {
-        entities.push_back(entity);
+    bool saveState(BinaryWriter& out) const override {
+        if (!incremental) {
+            return false;
+        }
+
+        std::vector<std::int32_t> level, parent, firstChild;
+        std::vector<double> nodeX, nodeY, nodeWidth, nodeHeight;
+        std::vector<char> mergePending;
+        std::vector<std::vector<int>> nodeAnimals;
+        for (int node = 0; node < nodeCount; node++) {
+            const Node& n = pool[node];
+            if (!n.entities.empty()) {
+                return false;   // Entity iaretileri saklanmaz; yklemede aa batan kurulur
+            }
+            level.push_back(n.level);
+            nodeX.push_back(n.x);
+            nodeY.push_back(n.y);
+            nodeWidth.push_back(n.width);
+            nodeHeight.push_back(n.height);
+            parent.push_back(n.parent);
+            firstChild.push_back(n.firstChild);
+            mergePending.push_back(n.mergePending);
+            nodeAnimals.push_back(n.animals);
+        }
+
+        out.value(static_cast<std::uint32_t>(1));   // Durum tr: artml QuadTree
+        out.array(level);
+        out.array(nodeX);
+        out.array(nodeY);
+        out.array(nodeWidth);
+        out.array(nodeHeight);
+        out.array(parent);
+        out.array(firstChild);
+        out.array(mergePending);
+        out.ragged(nodeAnimals, [](int animal) { return animal; });
+        out.array(freeBlocks);
+        out.array(leafTable);
+        out.ragged(mergeQueue, [](int node) { return node; });
+        return true;
     }
 
-    /*
-        TRKE:
-        processBirthQueue(), doum kuyruundan (birthQueue) yeni hayvanlar alr ve ortama ekler.
-    */
+    bool loadState(BinaryReader& in, int animalCount) override {
+        if (!incremental) {
+            return false;
+        }
+
+        std::uint32_t kind = 0;
+        std::vector<std::int32_t> level, parent, firstChild;
+        std::vector<double> nodeX, nodeY, nodeWidth, nodeHeight;
+        std::vector<char> mergePending;
+        std::vector<std::vector<int>> nodeAnimals;
+        std::vector<int> loadedFreeBlocks, loadedLeafTable;
+        std::vector<std::vector<int>> loadedMergeQueue;
+        in.value(kind);
+        in.array(level);
+        in.array(nodeX);
+        in.array(nodeY);
+        in.array(nodeWidth);
+        in.array(nodeHeight);
+        in.array(parent);
+        in.array(firstChild);
+        in.array(mergePending);
+        in.ragged(nodeAnimals, [](std::int32_t animal) { return static_cast<int>(animal); });
+        in.array(loadedFreeBlocks);
+        in.array(loadedLeafTable);
+        in.ragged(loadedMergeQueue, [](std::int32_t node) { return static_cast<int>(node); });
+
+        // Dm ve hayvan indekslerinin geerlilii denetlenir; bozuk durum yerine aa batan kurulur.
+        int count = static_cast<int>(level.size());
+        auto validNode = [count](int node) { return node >= 0 && node < count; };
+        if (!in.good() || kind != 1 || count < 1 || nodeX.size() != level.size() || nodeY.size() != level.size()
+            || nodeWidth.size() != level.size() || nodeHeight.size() != level.size() || parent.size() != level.size()
+            || firstChild.size() != level.size() || mergePending.size() != level.size()
+            || nodeAnimals.size() != level.size() || static_cast<int>(loadedLeafTable.size()) > animalCount
+            || loadedMergeQueue.size() != static_cast<size_t>(MAX_LEVELS + 1))
+        {
+            return false;
+        }
+        for (int node = 0; node < count; node++) {
+            if (level[node] < 0 || level[node] > MAX_LEVELS || (parent[node] >= 0 && !validNode(parent[node]))
+                || (firstChild[node] >= 0 && (firstChild[node] < 1 || !validNode(firstChild[node] + 3))))
+            {
+                return false;
+            }
+            for (int animal : nodeAnimals[node]) {
+                if (animal < 0 || animal >= animalCount) {
+                    return false;
+                }
+            }
+        }
+
+        /*
+            Aa yaps denetlenir: kkten inen her dme tam bir kez ulalmal, ocuun ebeveyni onu ieren
+            bloun sahibi ve seviyesi ebeveyninkinin bir fazlas olmaldr. Bylece dng ve MAX_LEVELS' aan
+            derinlik (sabit boyutlu gezinme ynlarn tarr) reddedilir. Aata olmayan her dm tam bir kez
+            bo bir blokta bulunmaldr (bo blok dmlerinin ebeveyn/seviye alanlar eskidir, denetlenmez).
+        */
+        if (parent[ROOT] != -1) {
+            return false;
+        }
+        std::vector<char> reached(count, 0);
+        std::vector<int> pending(1, ROOT);
+        reached[ROOT] = 1;
+        while (!pending.empty()) {
+            int node = pending.back();
+            pending.pop_back();
+            int first = firstChild[node];
+            if (first < 0) {
+                continue;
+            }
+            for (int child = first; child < first + 4; child++) {
+                if (reached[child] || parent[child] != node || level[child] != level[node] + 1) {
+                    return false;
+                }
+                reached[child] = 1;
+                pending.push_back(child);
+            }
+        }
+        for (int block : loadedFreeBlocks) {
+            if (block < 1 || !validNode(block + 3)) {
+                return false;
+            }
+            for (int node = block; node < block + 4; node++) {
+                if (reached[node] || firstChild[node] >= 0 || !nodeAnimals[node].empty()) {
+                    return false;
+                }
+                reached[node] = 1;
+            }
+        }
+        if (std::find(reached.begin(), reached.end(), 0) != reached.end()) {
+            return false;
+        }
+        for (int block : loadedFreeBlocks) {
+            for (int node = block; node < block + 4; node++) {
+                reached[node] = 0;  // Bundan sonra reached yalnzca aataki dmleri gsterir
+            }
+        }
+        for (int leaf : loadedLeafTable) {
+            if (!validNode(leaf) || !reached[leaf] || firstChild[leaf] >= 0) {
+                return false;
+            }
+        }
+        for (int lvl = 0; lvl <= MAX_LEVELS; lvl++) {
+            for (int node : loadedMergeQueue[lvl]) {
+                if (!validNode(node) || !reached[node] || level[node] != lvl) {
+                    return false;
+                }
+            }
+        }
+
+        if (static_cast<int>(pool.size()) < count) {
+            pool.resize(count);
+        }
+        for (int node = 0; node < count; node++) {
+            Node& n = pool[node];
+            n.level = level[node];
+            n.x = nodeX[node];
+            n.y = nodeY[node];
+            n.width = nodeWidth[node];
+            n.height = nodeHeight[node];
+            n.parent = parent[node];
+            n.firstChild = firstChild[node];
+            n.mergePending = mergePending[node] != 0;
+            n.animals.swap(nodeAnimals[node]);
+            n.entities.clear();
+        }
+        nodeCount = count;
+        freeBlocks.swap(loadedFreeBlocks);
+        leafTable.swap(loadedLeafTable);
+        mergeQueue.swap(loadedMergeQueue);
+        insertedEntityCount = 0;
+        return true;
+    }
+
+    /*
+        exportQuadTree(), Quadtree yapsn JSON formatnda dar aktarr.
+        kt biimi i ie "children" dizileridir; zyineleme yerine ak bir ynla nce dmler
+        n srada (pre-order) listelenir, sonra ters srada her dmn JSON'u ebeveynine tanr.
+    */
+    void exportQuadTree(json& frame_data) const {
+        std::vector<int> order;
+        std::vector<int> stack(1, ROOT);
+        while (!stack.empty()) {
+            int node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+            int first = pool[node].firstChild;
+            if (first >= 0) {
+                for (int i = 3; i >= 0; --i) {
+                    stack.push_back(first + i);
+                }
+            }
+        }
+
+        std::vector<json> nodeData(nodeCount);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            const Node& n = pool[*it];
+            json& node_data = nodeData[*it];
+            node_data["x"] = n.x;
+            node_data["y"] = n.y;
+            node_data["width"] = n.width;
+            node_data["height"] = n.height;
+            node_data["level"] = n.level;
+
+            if (n.firstChild >= 0) {
+                // Eski zyinelemeli ktyla ayn biim: her ocuk tek elemanl bir dizi iinde yazlr.
+                for (int i = 0; i < 4; ++i) {
+                    json child_data;
+                    child_data.push_back(std::move(nodeData[n.firstChild + i]));
+                    node_data["children"].push_back(std::move(child_data));
+                }
+            }
+        }
+        frame_data.push_back(std::move(nodeData[ROOT]));
+    }
+
+    void exportIndex(json& frame_data) const override {
+        exportQuadTree(frame_data);
+    }
+
+    // insertAnimal(), depo indeksi verilen hayvan kkten balayarak aaca yerletirir.
+    void insertAnimal(int animal) override {
+        insertAnimalAt(ROOT, animal);
+    }
+
+    // insertEntity(), Entity tipindeki varlklar (bitki vb.) kkten balayarak aaca yerletirir.
+    void insertEntity(Entity* entity) override {
+        insertEntityAt(ROOT, entity);
+    }
+
+    /*
+        visitAnimals(), (objX, objY) ve range deerine gre menzil iindeki ve tr speciesMask'te olan her hayvann
+        depo indeksi iin visit(index) arr (self hari). Ara vektr oluturmaz;
+        aa, sabit boyutlu bir ynla zyinelemeli srmle ayn srada gezilir.
+        (Yapraklar en fazla MAX_OBJECTS hayvan tuttuundan tr szgeci yaprak taramasnda uygulanr.)
+    */
+    template <typename Visitor>
+    void visitAnimals(int self, double objX, double objY, double range, std::uint32_t speciesMask, Visitor&& visit) const {
+        int stack[4 * (MAX_LEVELS + 1)];
+        int top = 0;
+        stack[top++] = ROOT;
+        while (top > 0) {
+            const Node& n = pool[stack[--top]];
+            if (n.firstChild >= 0) {
+                for (int i = 3; i >= 0; --i) {
+                    if (isWithinRange(pool[n.firstChild + i], objX, objY, range)) {
+                        stack[top++] = n.firstChild + i;
+                    }
+                }
+            }
+            else {
+                for (int animal : n.animals) {
+                    if (animal != self && ((speciesMask >> animalStore->species[animal]) & 1u)
+                        && std::hypot(animalStore->x[animal] - objX, animalStore->y[animal] - objY) <= range) {
+                        visit(animal);
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+        visitEntities(), ayn ekilde (objX, objY) ve range'e gre
+        menzil iindeki her Entity iin visit(entity) arr.
+    */
+    template <typename Visitor>
+    void visitEntities(double objX, double objY, double range, Visitor&& visit) const {
+        int stack[4 * (MAX_LEVELS + 1)];
+        int top = 0;
+        stack[top++] = ROOT;
+        while (top > 0) {
+            const Node& n = pool[stack[--top]];
+            if (n.firstChild >= 0) {
+                for (int i = 3; i >= 0; --i) {
+                    if (isWithinRange(pool[n.firstChild + i], objX, objY, range)) {
+                        stack[top++] = n.firstChild + i;
+                    }
+                }
+            }
+            else {
+                for (Entity* entity : n.entities) {
+                    if (std::hypot(entity->getX() - objX, entity->getY() - objY) <= range) {
+                        visit(entity);
+                    }
+                }
+            }
+        }
+    }
+
+    using SpatialIndex::retrieveAnimal;
+    using SpatialIndex::retrieveEntity;
+
+    // retrieveAnimal(), menzil iindeki (tr speciesMask'te olan) hayvanlarn depo indekslerini out'a ekler (self hari).
+    void retrieveAnimal(int self, double objX, double objY, double range, std::uint32_t speciesMask,
+        std::vector<int>& out) override
+    {
+        visitAnimals(self, objX, objY, range, speciesMask, [&out](int animal) { out.push_back(animal); });
+    }
+
+    // retrieveEntity(), menzil iindeki Entity'leri out'a ekler.
+    void retrieveEntity(double objX, double objY, double range, std::vector<Entity*>& out) override {
+        visitEntities(objX, objY, range, [&out](Entity* entity) { out.push_back(entity); });
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    UniformGrid, alan eit boyutlu hcrelere blen bir hcre listesi (cell list / spatial hash) yapsdr.
+    - Hcre boyu, poplasyondaki en byk detection_range deerine gre seilir; bylece bir sorgu
+      en fazla 3x3 hcreye bakar.
+    - Her admda sayma sralamas (counting sort) ile O(N) srede yeniden kurulur: hcre bana saym,
+      nek toplam (prefix sum) ve datm. Ayn hcredeki hayvanlarn indeksleri ve konumlar bitiik tutulur.
+    - QuadTree'den farkl olarak youn blgelerde derinlik snrna (MAX_LEVELS) taklp yaprak iinde
+      dorusal taramaya dmez.
+    - Hayvanlar kararl (stable) sayma sralamasyla (hcre, tr) srasna dizilir; bylece her hcrenin
+      iinde ayn trden hayvanlar bitiiktir. Sorgular bir satrdaki bitiik hcreleri tek aralk olarak tarar;
+      maskede olmayan trler mesafe hesabndan nce bitiik tr dizisinden (animalSpecies) elenir.
+    - (hcre, tr) anahtarl tek geili sralama hcre * NUM_ANIMALS saya ister; seyrek dnyalarda (hcre says
+      >> hayvan says) her admdaki sfrlama ve nek toplam bu sayalara hkmeder. Bu yzden tek gei yalnzca
+      sayalar hayvan saysn amadnda kullanlr; aksi halde N hayvan zerinden fazladan bir tr geii
+      yaplr ve saya says hcre says kadar kalr. ki yol ayn sray retir.
+    Alan dna tam (henz sarlmam) konumlar kenar hcrelere yerletirilir.
+*/
+class UniformGrid : public SpatialIndex {
+private:
+    static constexpr double MIN_CELL_SIZE = 1.0;
+
+    const AnimalStore* animalStore;
+    double width, height;
+    double cellSize;
+    int cols, rows;
+    bool sorted;                        // Eklenenler hcre srasna dizildi mi?
+
+    // Eklenen hayvanlar ve hcreleri (sralama ncesi)
+    std::vector<int> animalList;
+    std::vector<int> animalCell;
+    std::vector<int> speciesOrder;      // animalList konumlarnn tre gre kararl sras (ara dizi)
+    std::vector<int> bucketStart;       // Tek geili sralamada (hcre, tr) kovalarnn balanglar (ara dizi)
+
+    // Sralanm hayvanlar: hcre c'deki kaytlar [animalStart[c], animalStart[c + 1]) aralndadr ve tre gre dizilidir.
+    std::vector<int> animalStart;
+    std::vector<int> animalOrder;
+    std::vector<double> animalX;
+    std::vector<double> animalY;
+    std::vector<std::uint8_t> animalSpecies;
+
+    // Entity'ler (bitkiler) iin ayn dzen
+    std::vector<int> entityStart;
+    std::vector<Entity*> entityOrder;
+    std::vector<Entity*> entityList;
+
+    int cellCoord(double v, int count) const {
+        int c = static_cast<int>(std::floor(v / cellSize));
+        return std::clamp(c, 0, count - 1);
+    }
+
+    int cellOf(double objX, double objY) const {
+        return cellCoord(objY, rows) * cols + cellCoord(objX, cols);
+    }
+
+    // animalCellOf(), hayvann bulunduu hcreyi dndrr.
+    int animalCellOf(int animal) const {
+        return cellOf(animalStore->x[animal], animalStore->y[animal]);
+    }
+
+    // setCellSize(), hcre boyunu ve zgara boyutlarn (cols x rows) gnceller.
+    void setCellSize(double size) {
+        cellSize = std::max(size, MIN_CELL_SIZE);
+        cols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+        rows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+    }
+
+    // sortAnimals(), hayvanlar kararl sayma sralamasyla (hcre, tr) srasna dizer.
+    void sortAnimals() {
+        int n = static_cast<int>(animalList.size());
+        int cells = cols * rows;
+        animalOrder.resize(n);
+        animalX.resize(n);
+        animalY.resize(n);
+        animalSpecies.resize(n);
+
+        auto place = [this](int k, int slot) {
+            int index = animalList[k];
+            animalOrder[slot] = index;
+            animalX[slot] = animalStore->x[index];
+            animalY[slot] = animalStore->y[index];
+            animalSpecies[slot] = static_cast<std::uint8_t>(animalStore->species[index]);
+        };
+
+        if (static_cast<long long>(cells) * NUM_ANIMALS <= n) {
+            // Youn zgara: (hcre, tr) anahtaryla tek gei; hcre balanglar kova balanglarndan alnr.
+            int buckets = cells * NUM_ANIMALS;
+            auto bucketOf = [this](int k) { return animalCell[k] * NUM_ANIMALS + animalStore->species[animalList[k]]; };
+            bucketStart.assign(buckets + 1, 0);
+            for (int k = 0; k < n; k++) {
+                bucketStart[bucketOf(k) + 1]++;
+            }
+            for (int b = 0; b < buckets; b++) {
+                bucketStart[b + 1] += bucketStart[b];
+            }
+            animalStart.resize(cells + 1);
+            for (int c = 0; c <= cells; c++) {
+                animalStart[c] = bucketStart[c * NUM_ANIMALS];
+            }
+            for (int k = 0; k < n; k++) {
+                place(k, bucketStart[bucketOf(k)]++);
+            }
+        }
+        else {
+            // Seyrek zgara: nce tre, sonra hcreye gre iki kararl gei; sayalar hcre says kadardr.
+            int speciesStart[NUM_ANIMALS + 1] = {};
+            for (int k = 0; k < n; k++) {
+                speciesStart[animalStore->species[animalList[k]] + 1]++;
+            }
+            for (int species = 0; species < NUM_ANIMALS; species++) {
+                speciesStart[species + 1] += speciesStart[species];
+            }
+            speciesOrder.resize(n);
+            for (int k = 0; k < n; k++) {
+                speciesOrder[speciesStart[animalStore->species[animalList[k]]]++] = k;
+            }
+
+            animalStart.assign(cells + 1, 0);
+            for (int cell : animalCell) {
+                animalStart[cell + 1]++;
+            }
+            for (int c = 0; c < cells; c++) {
+                animalStart[c + 1] += animalStart[c];
+            }
+            std::vector<int> cursor(animalStart.begin(), animalStart.end() - 1);
+            for (int k : speciesOrder) {
+                place(k, cursor[animalCell[k]]++);
+            }
+        }
+    }
+
+    // sortEntities(), entityList'i hcre srasna dizer (counting sort).
+    void sortEntities() {
+        std::vector<int> entityCell(entityList.size());
+        entityStart.assign(cols * rows + 1, 0);
+        for (size_t i = 0; i < entityList.size(); i++) {
+            entityCell[i] = cellOf(entityList[i]->getX(), entityList[i]->getY());
+            entityStart[entityCell[i] + 1]++;
+        }
+        for (int c = 0; c < cols * rows; c++) {
+            entityStart[c + 1] += entityStart[c];
+        }
+
+        entityOrder.resize(entityList.size());
+        std::vector<int> cursor(entityStart.begin(), entityStart.end() - 1);
+        for (size_t i = 0; i < entityList.size(); i++) {
+            entityOrder[cursor[entityCell[i]]++] = entityList[i];
+        }
+    }
+
+    // ensureSorted(), tekil eklemelerden sonra ilk sorguda sralamay yapar.
+    void ensureSorted() {
+        if (!sorted) {
+            sortAnimals();
+            sortEntities();
+            sorted = true;
+        }
+    }
+
+public:
+    /*
+        UniformGrid kurucusu: alan boyutlar (w x h), balang hcre boyu ve hayvan deposu.
+        Hcre boyu rebuild() srasnda en byk alglama menziline gre yeniden ayarlanr.
+    */
+    UniformGrid(double w, double h, double initialCellSize, const AnimalStore* store)
+        : animalStore(store), width(w), height(h), cellSize(initialCellSize), cols(1), rows(1), sorted(true)
+    {
+        setCellSize(initialCellSize);
+        clear();
+    }
+
+    void clear() override {
+        animalList.clear();
+        animalCell.clear();
+        entityList.clear();
+        animalOrder.clear();
+        animalX.clear();
+        animalY.clear();
+        animalSpecies.clear();
+        entityOrder.clear();
+        animalStart.assign(cols * rows + 1, 0);
+        entityStart.assign(cols * rows + 1, 0);
+        sorted = true;
+    }
+
+    /*
+        insertAnimal() ve insertEntity() tekil ekleme iindir; sralama bir sonraki sorgudan nce
+        toplu olarak yaplr. Her admda tm poplasyon iin rebuild() kullanlmas tercih edilir.
+    */
+    void insertAnimal(int animal) override {
+        animalList.push_back(animal);
+        animalCell.push_back(animalCellOf(animal));
+        sorted = false;
+    }
+
+    void insertEntity(Entity* entity) override {
+        entityList.push_back(entity);
+        sorted = false;
+    }
+
+    /*
+        rebuild(), hcre boyunu en byk detection_range'e gre ayarlar ve
+        hayvanlar/entity'leri sayma sralamasyla tek geite yerletirir.
+    */
+    void rebuild(int animalCount, const std::vector<Entity*>& entities) override {
+        double maxRange = 0.0;
+        for (int index = 0; index < animalCount; index++) {
+            maxRange = std::max(maxRange, animalStore->detection_range[index]);
+        }
+        if (maxRange > 0.0 && maxRange != cellSize) {
+            setCellSize(maxRange);
+        }
+
+        animalList.resize(animalCount);
+        animalCell.resize(animalCount);
+        for (int index = 0; index < animalCount; index++) {
+            animalList[index] = index;
+            animalCell[index] = animalCellOf(index);
+        }
+        sortAnimals();
+
+        entityList.assign(entities.begin(), entities.end());
+        sortEntities();
+        sorted = true;
+    }
+
+    /*
+        visitAnimals(), (objX, objY) merkezli ve range yarapl dairenin kapsad hcreleri tarar,
+        daire iindeki ve tr speciesMask'te olan her hayvann depo indeksi iin visit(index) arr (self hari).
+    */
+    template <typename Visitor>
+    void visitAnimals(int self, double objX, double objY, double range, std::uint32_t speciesMask, Visitor&& visit) {
+        ensureSorted();
+        int cx0 = cellCoord(objX - range, cols), cx1 = cellCoord(objX + range, cols);
+        int cy0 = cellCoord(objY - range, rows), cy1 = cellCoord(objY + range, rows);
+
+        // Ayn satrdaki bitiik hcreler bellekte de bitiik olduundan tek aralk olarak taranr.
+        for (int cy = cy0; cy <= cy1; cy++) {
+            int begin = animalStart[cy * cols + cx0];
+            int end = animalStart[cy * cols + cx1 + 1];
+            for (int slot = begin; slot < end; slot++) {
+                if (!((speciesMask >> animalSpecies[slot]) & 1u)) {
+                    continue;
+                }
+                int animal = animalOrder[slot];
+                if (animal != self && std::hypot(animalX[slot] - objX, animalY[slot] - objY) <= range) {
+                    visit(animal);
+                }
+            }
+        }
+    }
+
+    /*
+        visitEntities(), ayn hcre taramasyla menzil iindeki her Entity iin visit(entity) arr.
+    */
+    template <typename Visitor>
+    void visitEntities(double objX, double objY, double range, Visitor&& visit) {
+        ensureSorted();
+        int cx0 = cellCoord(objX - range, cols), cx1 = cellCoord(objX + range, cols);
+        int cy0 = cellCoord(objY - range, rows), cy1 = cellCoord(objY + range, rows);
+
+        for (int cy = cy0; cy <= cy1; cy++) {
+            int begin = entityStart[cy * cols + cx0];
+            int end = entityStart[cy * cols + cx1 + 1];
+            for (int slot = begin; slot < end; slot++) {
+                Entity* entity = entityOrder[slot];
+                if (std::hypot(entity->getX() - objX, entity->getY() - objY) <= range) {
+                    visit(entity);
+                }
+            }
+        }
+    }
+
+    using SpatialIndex::retrieveAnimal;
+    using SpatialIndex::retrieveEntity;
+
+    void retrieveAnimal(int self, double objX, double objY, double range, std::uint32_t speciesMask,
+        std::vector<int>& out) override
+    {
+        visitAnimals(self, objX, objY, range, speciesMask, [&out](int animal) { out.push_back(animal); });
+    }
+
+    void retrieveEntity(double objX, double objY, double range, std::vector<Entity*>& out) override {
+        visitEntities(objX, objY, range, [&out](Entity* entity) { out.push_back(entity); });
+    }
+
+    // exportIndex(), zgarann hcre boyunu ve boyutlarn dar aktarr.
+    void exportIndex(json& frame_data) const override {
+        json grid_data;
+        grid_data["cell_size"] = cellSize;
+        grid_data["cols"] = cols;
+        grid_data["rows"] = rows;
+        frame_data.push_back(grid_data);
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    PlantIndex, bitkiler iin ayr ve deimez (immutable) bir uzaysal indekstir.
+    Bitkiler hareket etmedii iin her admda yeniden eklenmeleri gereksizdir:
+     - ndeks kurulumda bir kez, sayma sralamasyla (counting sort) hcre srasna dizilmi bir zgara olarak kurulur.
+     - Yalnzca bitki eklendiinde/silindiinde "kirli" iaretlenir ve bir sonraki sorguda yeniden kurulur.
+     - Hcre iindeki bitkilerin koordinatlar bitiik dizilerde tutulur; sorgular dorudan Plant* dndrr,
+       Entity -> Plant dnm (dynamic_cast) gerekmez.
+*/
+class PlantIndex {
+private:
+    double width, height;
+    double cellSize;
+    int cols, rows;
+    bool dirty;
+
+    std::vector<Plant*> plants;             // Kaytl bitkiler (ekleme sras)
+
+    // Sralanm dzen: hcre h'deki bitkiler [cellStart[h], cellStart[h + 1]) aralndadr.
+    std::vector<int> cellStart;
+    std::vector<Plant*> sortedPlants;
+    std::vector<double> sortedX;
+    std::vector<double> sortedY;
+
+    int cellCoord(double v, int count) const {
+        int c = static_cast<int>(std::floor(v / cellSize));
+        return std::clamp(c, 0, count - 1);
+    }
+
+    // build(), bitkileri hcrelerine gre sayma sralamasyla dizer.
+    void build() {
+        std::vector<int> plantCell(plants.size());
+        cellStart.assign(cols * rows + 1, 0);
+        for (size_t i = 0; i < plants.size(); i++) {
+            plantCell[i] = cellCoord(plants[i]->getY(), rows) * cols + cellCoord(plants[i]->getX(), cols);
+            cellStart[plantCell[i] + 1]++;
+        }
+        for (int c = 0; c < cols * rows; c++) {
+            cellStart[c + 1] += cellStart[c];
+        }
+
+        sortedPlants.resize(plants.size());
+        sortedX.resize(plants.size());
+        sortedY.resize(plants.size());
+        std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < plants.size(); i++) {
+            int slot = cursor[plantCell[i]]++;
+            sortedPlants[slot] = plants[i];
+            sortedX[slot] = plants[i]->getX();
+            sortedY[slot] = plants[i]->getY();
+        }
+        dirty = false;
+    }
+
+public:
+    /*
+        PlantIndex kurucusu: alan boyutlar (w x h) ve hcre boyu.
+        Hcre boyu tipik alglama menziline yakn seilirse bir sorgu yaklak 3x3 hcreye bakar.
+    */
+    PlantIndex(double w, double h, double cellSize_)
+        : width(w), height(h), cellSize(std::max(cellSize_, 1.0)), dirty(false)
+    {
+        cols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+        rows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+        cellStart.assign(cols * rows + 1, 0);
+    }
+
+    // addPlant(), indekse bitki ekler; indeks bir sonraki sorguda yeniden kurulur.
+    void addPlant(Plant* plant) {
+        plants.push_back(plant);
+        dirty = true;
+    }
+
+    // removePlant(), bitkiyi indeksten karr; indeks bir sonraki sorguda yeniden kurulur.
+    void removePlant(Plant* plant) {
+        plants.erase(std::remove(plants.begin(), plants.end(), plant), plants.end());
+        dirty = true;
+    }
+
+    size_t size() const { return plants.size(); }
+
+    // prepare(), indeks kirliyse imdi kurar. Paralel sorgulardan nce arlmaldr (sorgular indeksi deitirmesin).
+    void prepare() {
+        if (dirty) {
+            build();
+        }
+    }
+
+    /*
+        visitPlants(), (objX, objY) merkezli ve range yarapl daire iindeki her bitki iin visit(plant) arr.
+    */
+    template <typename Visitor>
+    void visitPlants(double objX, double objY, double range, Visitor&& visit) {
+        if (dirty) {
+            build();
+        }
+
+        int cx0 = cellCoord(objX - range, cols), cx1 = cellCoord(objX + range, cols);
+        int cy0 = cellCoord(objY - range, rows), cy1 = cellCoord(objY + range, rows);
+
+        for (int cy = cy0; cy <= cy1; cy++) {
+            int begin = cellStart[cy * cols + cx0];
+            int end = cellStart[cy * cols + cx1 + 1];
+            for (int slot = begin; slot < end; slot++) {
+                if (std::hypot(sortedX[slot] - objX, sortedY[slot] - objY) <= range) {
+                    visit(sortedPlants[slot]);
+                }
+            }
+        }
+    }
+
+    // retrievePlants(), daire iindeki bitkileri out tamponuna ekler (out temizlenmez).
+    void retrievePlants(double objX, double objY, double range, std::vector<Plant*>& out) {
+        visitPlants(objX, objY, range, [&out](Plant* plant) { out.push_back(plant); });
+    }
+
+    std::vector<Plant*> retrievePlants(double objX, double objY, double range) {
+        std::vector<Plant*> result;
+        retrievePlants(objX, objY, range, result);
+        return result;
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    OutputWriter, simlasyon ktlarn ayr bir yazc i paracnda diske yazar.
+    - Simlasyon i parac veriyi string olarak hazrlar ve snrl bir kuyrua brakr; dosya ilemlerinin
+      tamam (ama, yazma, kapatma) yazc i paracnda yaplr. Kuyruk doluysa yalnzca write() bekler.
+    - Dosyalar kapatlana kadar ak kalr ve her birine byk bir yazma tamponu verilir.
+    - Dosyalar open() ile dnen numara ile ya da alrken verilen ad ile seilir.
+    - Ayn dosyaya yaplan yazmalar sras korunarak uygulanr.
+*/
+class OutputWriter {
+private:
+    static constexpr size_t QUEUE_CAPACITY = 256;          // Kuyruktaki en fazla i says
+    static constexpr size_t FILE_BUFFER_SIZE = 1 << 20;    // Dosya bana yazma tamponu (bayt)
+
+    enum JobType {
+        OpenJob,
+        WriteJob,
+        CloseJob,
+        FlushJob
+    };
+
+    struct Job {
+        JobType type;
+        int file;
+        long long position;     // WriteJob: >= 0 ise bu konuma yazlr, aksi halde sona eklenir
+        std::string data;       // OpenJob: dosya ad, WriteJob: yazlacak bayt dizisi
+        bool binary;
+    };
+
+    struct OpenFile {
+        std::vector<char> buffer;       // stream'den nce tanml: stream kapanrken tampon hl geerli olmal
+        std::ofstream stream;
+        std::string name;
+    };
+
+    // Halka kuyruk: [head, head + count) aralndaki iler bekliyor
+    std::vector<Job> queue;
+    size_t head;
+    size_t count;
+    unsigned long long submitted;       // Kuyrua giren i says
+    unsigned long long completed;       // Yazcnn bitirdii i says
+    bool stopping;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable progress;
+
+    // Yalnzca yazc i parac kullanr
+    std::vector<std::unique_ptr<OpenFile>> files;
+
+    // Yalnzca simlasyon i parac kullanr
+    std::map<std::string, int> fileIds;
+    int nextFile;
+
+    std::thread thread;
+
+    unsigned long long push(Job&& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return count < queue.size(); });
+        queue[(head + count) % queue.size()] = std::move(job);
+        count++;
+        unsigned long long ticket = ++submitted;
+        lock.unlock();
+        notEmpty.notify_one();
+        return ticket;
+    }
+
+    void run(Job& job) {
+        if (job.type == OpenJob) {
+            if (files.size() <= static_cast<size_t>(job.file)) {
+                files.resize(job.file + 1);
+            }
+            std::unique_ptr<OpenFile> file(new OpenFile());
+            file->buffer.resize(FILE_BUFFER_SIZE);
+            file->stream.rdbuf()->pubsetbuf(file->buffer.data(), static_cast<std::streamsize>(file->buffer.size()));
+            std::ios_base::openmode mode = std::ios_base::out | std::ios_base::trunc;
+            if (job.binary) {
+                mode |= std::ios_base::binary;
+            }
+            file->stream.open(job.data, mode);
+            if (!file->stream.is_open()) {
+                std::cerr << "Dosya acma hatasi: " << job.data << std::endl;
+                return;
+            }
+            file->name = job.data;
+            files[job.file] = std::move(file);
+            return;
+        }
+
+        if (job.type == FlushJob) {
+            for (auto& file : files) {
+                if (file) {
+                    file->stream.flush();
+                }
+            }
+            return;
+        }
+
+        if (static_cast<size_t>(job.file) >= files.size() || !files[job.file]) {
+            return;     // Alamam dosya; hata alta bildirildi
+        }
+        OpenFile& file = *files[job.file];
+
+        if (job.type == WriteJob) {
+            if (job.position >= 0) {
+                file.stream.seekp(job.position);
+                file.stream.write(job.data.data(), static_cast<std::streamsize>(job.data.size()));
+                file.stream.seekp(0, std::ios_base::end);
+            }
+            else {
+                file.stream.write(job.data.data(), static_cast<std::streamsize>(job.data.size()));
+            }
+            if (!file.stream) {
+                std::cerr << "Dosya yazma hatasi: " << file.name << std::endl;
+                file.stream.clear();
+            }
+        }
+        else if (job.type == CloseJob) {
+            file.stream.close();
+            files[job.file].reset();
+        }
+    }
+
+    void writerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this] { return stopping || count > 0; });
+                if (count == 0) {
+                    return;     // Kapan ve kuyruk bo
+                }
+                job = std::move(queue[head]);
+                head = (head + 1) % queue.size();
+                count--;
+            }
+            notFull.notify_one();
+
+            run(job);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed++;
+            }
+            progress.notify_all();
+        }
+    }
+
+public:
+    OutputWriter()
+        : queue(QUEUE_CAPACITY), head(0), count(0), submitted(0), completed(0), stopping(false), nextFile(0)
+    {
+        thread = std::thread(&OutputWriter::writerLoop, this);
+    }
+
+    // Kuyruktaki tm ileri yazar, ak dosyalar kapatr
+    ~OutputWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        notEmpty.notify_one();
+        thread.join();
+    }
+
+    // Dosyay sfrlayarak aar; ayn adla ak bir dosya varsa nce kapatlr
+    int open(const std::string& filename, bool binary = false) {
+        close(filename);
+        int file = nextFile++;
+        fileIds[filename] = file;
+        push({ OpenJob, file, -1, filename, binary });
+        return file;
+    }
+
+    void write(int file, std::string&& data, long long position = -1) {
+        push({ WriteJob, file, position, std::move(data), false });
+    }
+
+    // Ada gre yazma; dosya open() ile almamsa veri yazlmaz ve hata bildirilir
+    void write(const std::string& filename, std::string&& data) {
+        auto it = fileIds.find(filename);
+        if (it == fileIds.end()) {
+            std::cerr << "Dosya acik degil: " << filename << std::endl;
+            return;
+        }
+        write(it->second, std::move(data));
+    }
+
+    void close(int file) {
+        for (auto it = fileIds.begin(); it != fileIds.end(); ++it) {
+            if (it->second == file) {
+                fileIds.erase(it);
+                break;
+            }
+        }
+        push({ CloseJob, file, -1, std::string(), false });
+    }
+
+    void close(const std::string& filename) {
+        auto it = fileIds.find(filename);
+        if (it != fileIds.end()) {
+            close(it->second);
+        }
+    }
+
+    // O ana kadar verilen tm iler yazlp dosyalar boaltlana kadar bekler
+    void flush() {
+        unsigned long long ticket = push({ FlushJob, -1, -1, std::string(), false });
+        std::unique_lock<std::mutex> lock(mutex);
+        progress.wait(lock, [this, ticket] { return completed >= ticket; });
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    TrajectoryWriter, hayvanlarn adm bana deiken verilerini (id, x, y, health, hunger, state) ikili,
+    stun dzenli bir dosyaya yazar. Her adm bellekte tek bir ardk blok olarak hazrlanr ve OutputWriter'a
+    verilir; dosya kou boyunca ak kalr.
+    Tm saylar little-endian'dr ve her stun 4 baytlk snra hizaldr, bylece okuyucu dosyay mmap ile
+    ap stunlar dorudan dizi olarak grebilir.
+
+    Dosya dzeni:
+      Balk (32 bayt):
+        char     magic[8]       "ABMTRAJ\0"
+        uint32   version        1
+        uint32   headerSize     32
+        uint32   columnCount    6
+        uint32   stepCount      close() ile yazlr (0: dosya kapatlmam)
+        uint64   indexOffset    close() ile yazlr (0: indeks yok, bloklar batan srayla okunur)
+      Adm blou:
+        int32    step
+        uint32   count
+        int32    id[count]
+        float32  x[count], y[count], health[count], hunger[count]
+        uint8    state[count], ardndan 4'n katna tamamlayan dolgu
+      ndeks (indexOffset'te, stepCount kayt):
+        int32    step
+        uint32   count
+        uint64   offset         Adm blounun dosya bandan uzakl
+*/
+class TrajectoryWriter {
+private:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t HEADER_SIZE = 32;
+    static constexpr std::uint32_t COLUMN_COUNT = 6;
+
+    struct IndexEntry {
+        std::int32_t step;
+        std::uint32_t count;
+        std::uint64_t offset;
+    };
+    static_assert(sizeof(IndexEntry) == 16, "indeks kaydi dolgusuz 16 bayt olmali");
+
+    OutputWriter* output;
+    int file;                           // output iindeki dosya numaras (-1: ak deil)
+    std::uint64_t position;             // Dosyaya verilmi bayt says (sonraki bloun konumu)
+    std::vector<IndexEntry> index;
+    std::string block;                  // Hazrlanmakta olan blok
+
+    // Stun dnm iin admlar arasnda yeniden kullanlan tamponlar
+    std::vector<float> floatColumn;
+    std::vector<std::uint8_t> byteColumn;
+
+    template <typename T>
+    void writeRaw(const T* data, size_t count) {
+        size_t bytes = sizeof(T) * count;
+        block.append(reinterpret_cast<const char*>(data), bytes);
+        position += bytes;
+    }
+
+    template <typename T>
+    void writeValue(T value) {
+        writeRaw(&value, 1);
+    }
+
+    void writeFloatColumn(const std::vector<double>& column) {
+        floatColumn.assign(column.begin(), column.end());
+        writeRaw(floatColumn.data(), floatColumn.size());
+    }
+
+    void writeHeader(std::uint32_t stepCount, std::uint64_t indexOffset) {
+        const char magic[8] = { 'A', 'B', 'M', 'T', 'R', 'A', 'J', '\0' };
+        writeRaw(magic, 8);
+        writeValue(VERSION);
+        writeValue(HEADER_SIZE);
+        writeValue(COLUMN_COUNT);
+        writeValue(stepCount);
+        writeValue(indexOffset);
+    }
+
+public:
+    TrajectoryWriter() : output(nullptr), file(-1), position(0) {}
+
+    ~TrajectoryWriter() {
+        close();
+    }
+
+    bool isOpen() const { return file >= 0; }
+
+    // Dosyay sfrlar ve bal yazar (stepCount ve indexOffset close() ile doldurulur)
+    void open(OutputWriter& writer, const std::string& filename) {
+        close();
+        output = &writer;
+        file = output->open(filename, true);
+        position = 0;
+        index.clear();
+        writeHeader(0, 0);
+        output->write(file, std::move(block));
+        block.clear();
+    }
+
+    void writeStep(int step, const AnimalStore& animals) {
+        if (file < 0) {
+            return;
+        }
+
+        std::uint32_t count = static_cast<std::uint32_t>(animals.size());
+        index.push_back({ step, count, position });
+
+        writeValue(static_cast<std::int32_t>(step));
+        writeValue(count);
+        writeRaw(animals.id.data(), count);
+        writeFloatColumn(animals.x);
+        writeFloatColumn(animals.y);
+        writeFloatColumn(animals.health);
+        writeFloatColumn(animals.hunger);
+
+        byteColumn.assign(animals.state.begin(), animals.state.end());
+        byteColumn.resize((count + 3) / 4 * 4, 0);
+        writeRaw(byteColumn.data(), byteColumn.size());
+
+        output->write(file, std::move(block));
+        block.clear();
+    }
+
+    // ndeksi dosya sonuna ekler, bal gnceller ve dosyay kapatr
+    void close() {
+        if (file < 0) {
+            return;
+        }
+
+        std::uint64_t indexOffset = position;
+        writeRaw(index.data(), index.size());
+        output->write(file, std::move(block));
+        block.clear();
+
+        writeHeader(static_cast<std::uint32_t>(index.size()), indexOffset);
+        output->write(file, std::move(block), 0);
+        block.clear();
+
+        output->close(file);
+        file = -1;
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    StepProfiler, Environment::update() admnn evrelerini (istatistik toplama, doumlar, llerin silinmesi, hayvan
+    gncellemesi, hareket, indeks kurulumu, komu listeleri, alglama, bitki yenilenmesi ve save* arlar) ayr ayr ler.
+    - Kapalyken mark() yalnzca bir bayrak denetler; akken her evre sonunda saat bir kez okunur.
+    - report() her evre iin p50/p95/p99/max deerlerini (milisaniye) yazar.
+    - openCsv() ile alan dosyaya her adm iin bir satr (step, animals, evre sreleri, total; saniye) yazlr.
+*/
+class StepProfiler {
+public:
+    enum Phase {
+        CollectStatisticsPhase,     // collectStatistics()
+        SaveTrajectoryPhase,        // saveAnimalDynamicData()
+        BirthPhase,                 // processBirthQueue() (yeni doanlarn saveAnimalStaticData() arlar dahil)
+        RemoveDeadPhase,            // llerin iaretlenmesi ve compactAnimals()
+        AnimalUpdatePhase,          // Animal::update() (ve konum kayd)
+        MovementPhase,              // moveAnimals(): konumlarn ilerletilmesi ve snr iine alnmas
+        IndexBuildPhase,            // spatialIndex->update()
+        NeighbourListPhase,         // refreshNeighbourLists() (Verlet listeleri aksa)
+        DetectionPhase,             // detectRange()
+        PlantRegrowthPhase,         // food_rej_per_step
+        SavePlantsPhase,            // savePlantData()
+        SaveStatisticsPhase,        // saveStatistics()
+        NUM_PHASES
+    };
+
+    static const char* phaseName(int phase) {
+        static const char* const names[NUM_PHASES] = {
+            "collect_statistics", "save_trajectory", "births", "remove_dead", "animal_update", "movement",
+            "index_build", "neighbour_lists", "detection", "plant_regrowth", "save_plants", "save_statistics"
+        };
+        return names[phase];
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool enabled;
+    Clock::time_point last;                             // Son mark() (veya beginStep()) an
+    std::array<double, NUM_PHASES> current;             // Bu admn evre sreleri (saniye)
+    std::vector<std::array<double, NUM_PHASES>> samples;    // llen her admn evre sreleri
+
+    OutputWriter* output;
+    int csvFile;                                        // output iindeki dosya numaras (-1: ak deil)
+
+    // Sral dizide yzdelik (en yakn sra yntemi)
+    static double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+        return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+    }
+
+public:
+    StepProfiler() : enabled(false), output(nullptr), csvFile(-1) {
+        current.fill(0);
+    }
+
+    ~StepProfiler() {
+        closeCsv();
+    }
+
+    void setEnabled(bool value) { enabled = value; }
+    bool isEnabled() const { return enabled; }
+
+    // Adm bana CSV dosyasn aar ve balk satrn yazar
+    void openCsv(OutputWriter& writer, const std::string& filename) {
+        closeCsv();
+        output = &writer;
+        csvFile = output->open(filename);
+        std::string header = "step,animals";
+        for (int phase = 0; phase < NUM_PHASES; phase++) {
+            header += ",";
+            header += phaseName(phase);
+        }
+        header += ",total\n";
+        output->write(csvFile, std::move(header));
+    }
+
+    void closeCsv() {
+        if (csvFile >= 0) {
+            output->close(csvFile);
+            csvFile = -1;
+        }
+    }
+
+    void beginStep() {
+        if (!enabled) {
+            return;
+        }
+        current.fill(0);
+        last = Clock::now();
+    }
+
+    // Son iaretten bu yana geen sreyi phase evresine yazar
+    void mark(Phase phase) {
+        if (!enabled) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        current[phase] += std::chrono::duration<double>(now - last).count();
+        last = now;
+    }
+
+    void endStep(int step, int animalCount) {
+        if (!enabled) {
+            return;
+        }
+        samples.push_back(current);
+        if (csvFile >= 0) {
+            std::ostringstream row;
+            row << step << "," << animalCount;
+            double total = 0;
+            for (double seconds : current) {
+                row << "," << seconds;
+                total += seconds;
+            }
+            row << "," << total << "\n";
+            output->write(csvFile, row.str());
+        }
+    }
+
+    // Evre bana sre dalmn (milisaniye) ve toplam sre iindeki payn yazar
+    void report(std::ostream& out) const {
+        if (samples.empty()) {
+            return;
+        }
+
+        std::vector<double> totals(samples.size(), 0.0);
+        double grandTotal = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            for (double seconds : samples[i]) {
+                totals[i] += seconds;
+            }
+            grandTotal += totals[i];
+        }
+
+        auto printRow = [&out, grandTotal](const std::string& name, std::vector<double>& values) {
+            double sum = 0;
+            for (double value : values) {
+                sum += value;
+            }
+            std::sort(values.begin(), values.end());
+            out << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(4)
+                << std::setw(12) << percentile(values, 50) * 1000
+                << std::setw(12) << percentile(values, 95) * 1000
+                << std::setw(12) << percentile(values, 99) * 1000
+                << std::setw(12) << values.back() * 1000
+                << std::setw(9) << std::setprecision(1) << (grandTotal > 0 ? sum / grandTotal * 100 : 0) << "%\n";
+        };
+
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+
+        out << "Adim profili (" << samples.size() << " adim, milisaniye):\n";
+        out << std::left << std::setw(20) << "evre" << std::right << std::setw(12) << "p50" << std::setw(12) << "p95"
+            << std::setw(12) << "p99" << std::setw(12) << "max" << std::setw(10) << "pay" << "\n";
+        std::vector<double> values(samples.size());
+        for (int phase = 0; phase < NUM_PHASES; phase++) {
+            for (size_t i = 0; i < samples.size(); i++) {
+                values[i] = samples[i][phase];
+            }
+            printRow(phaseName(phase), values);
+        }
+        printRow("total", totals);
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    ThreadPool, paralel adm iin sabit sayda i paracn admlar boyunca canl tutar.
+    parallelFor(n, f), [0, n) araln i parac says kadar bitiik paraya bler ve her para iin
+    f(begin, end) arr; aran i parac da ilk paray iler ve tm paralar bitince dner.
+    Her indeksin ii dierlerinden bamsz olmaldr; paralama sonucu etkilemez.
+*/
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int, int)>* task;
+    int taskSize;
+    unsigned generation;        // Her parallelFor arsnda artar; iiler yeni ii bununla fark eder
+    int pending;                // ini bitirmemi ii says
+    bool stopping;
+
+    void runChunk(int worker, int n, const std::function<void(int, int)>& f) const {
+        long long threads = size();
+        int begin = static_cast<int>(n * worker / threads);
+        int end = static_cast<int>(n * (worker + 1) / threads);
+        if (begin < end) {
+            f(begin, end);
+        }
+    }
+
+    void workerLoop(int worker) {
+        unsigned seen = 0;
+        while (true) {
+            const std::function<void(int, int)>* job;
+            int n;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                job = task;
+                n = taskSize;
+            }
+
+            runChunk(worker, n, *job);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+public:
+    // threadCount: aran i parac dahil toplam i parac says
+    explicit ThreadPool(int threadCount)
+        : task(nullptr), taskSize(0), generation(0), pending(0), stopping(false)
+    {
+        for (int worker = 1; worker < threadCount; worker++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, worker);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    void parallelFor(int n, const std::function<void(int, int)>& f) {
+        if (workers.empty()) {
+            f(0, n);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &f;
+            taskSize = n;
+            pending = static_cast<int>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+
+        runChunk(0, n, f);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        task = nullptr;
+    }
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    Environment, tm hayvanlar, bitkileri, quadtree yapsn ve simlasyon dngsn yneten snftr.
+    - addAnimal() ve addEntity() fonksiyonlar ile ekleme yaplr.
+    - Uzaysal indeks (QuadTree veya UniformGrid) kurucuda ya da setSpatialIndex() ile seilir.
+    - Bitkiler hareket etmedii iin ayr, deimez bir PlantIndex'te tutulur.
+    - update() fonksiyonu, her admda hayvanlarn ve bitkilerin durumunu gnceller.
+    - processBirthQueue() ile doum kuyruundaki yeni hayvanlar eklenir.
+    - Veriler JSON formatnda dosyaya kaydedilebilir; hayvanlarn adm verileri ikili trajectory dosyasna yazlr.
+      Dosya ilemleri OutputWriter'n i paracnda yaplr; adm yalnzca hazrlanan veriyi kuyrua brakr.
+    - Hayvanlar komularn adm bandaki kopyadan (previousState) okur, bakalarna yazmalarn StepIntent'e
+      brakr; kaytlar hayvan srasyla uygulanr. setThreadCount() ile alglama ve hayvan gncellemesi i
+      paracklarna datlr; adm kurallar ayn olduundan sonu i parac saysna (0 dahil) bal deildir.
+*/
+class Environment {
+public:
+    // Seilebilir uzaysal indeks trleri
+    enum SpatialIndexType {
+        QuadTreeIndex,
+        IncrementalQuadTreeIndex,
+        UniformGridIndex
+    };
+
+    // JSON ktlarnn yazm biimi
+    enum OutputFormat {
+        JsonArrayOutput,    // Tek bir JSON dizisi, 4 bolukla girintili ("[" ... "]")
+        NdjsonOutput        // Satr bana bir sktrlm JSON nesnesi; her admdan sonra geerli bir dosyadr
+    };
+
+    // Kaydedilen veri aklar
+    enum RecordingStream {
+        AnimalTrajectoryStream,     // animal_dynamic_data.bin
+        PlantStream,                // plant_data1.json
+        PositionHistoryStream,      // animalPositions
+        StatisticsStream,           // statistics.json
+        AnimalStaticStream,         // animal_static_data.json (doumda bir kez; yalnzca ak/kapal olmas dikkate alnr)
+        NUM_RECORDING_STREAMS
+    };
+
+    /*
+        RecordingWindow, bir akn hangi admlarda kaydedileceini belirler: [start, stop] aralnda,
+        start'tan itibaren her interval admda bir (stop < 0: kounun sonuna kadar). interval <= 0: ak kapal.
+    */
+    struct RecordingWindow {
+        int interval;
+        int start;
+        int stop;
+
+        bool enabled() const { return interval > 0; }
+
+        bool contains(int step) const {
+            return enabled() && step >= start && (stop < 0 || step <= stop) && (step - start) % interval == 0;
+        }
+    };
+
+private:
+    SpatialIndex* spatialIndex;
+    PlantIndex plantIndex;
+    int width;
+    int height;
+
+    // Bitki olmayan (hareket edebilen) entity'ler; her admda uzaysal indekse eklenir.
+    std::vector<Entity*> dynamicEntities;
+
+    // JSON kt ayarlar (bkz. setOutputFormat)
+    OutputFormat outputFormat;
+    double outputScale;                 // Ondalk deerler 1/outputScale'e yuvarlanr (0: tam hassasiyet)
+
+    // Bitki kts ayarlar (bkz. setPlantOutput)
+    int plantKeyframeInterval;          // Her bu kadar admda bir tm bitkiler yazlr
+    double plantFoodTolerance;          // Ara admlarda food deeri bundan fazla deien bitkiler yazlr
+    std::vector<double> writtenPlantFood;   // Bitki bana dosyaya en son yazlan food deeri
+    int nextPlantKeyframe;                  // Bu admdan itibaren kaydedilen ilk bitki adm anahtar karedir
+
+    // Ak bana kayt pencereleri (bkz. setRecording); kaydedilmeyen admlarda hibir veri hazrlanmaz
+    std::array<RecordingWindow, NUM_RECORDING_STREAMS> recording;
+
+    // Ortamn kendi dosyalarnn yazld dizin/nek (bkz. setOutputPath)
+    std::string outputPath;
+
+    // JSON dizisi ktlarnda ilk kaydn yazlp yazlmad (dosya bana)
+    bool isFirstStaticWrite = true;
+    bool isFirstPlantStaticWrite = true;
+    bool isFirstPlantWrite = true;
+    bool isFirstStatisticsWrite = true;
+    bool isFirstIndexWrite = true;
+
+    // Adm banda toplanan hayvan istatistikleri; adm sonunda bitki ortalamasyla birlikte yazlr
+    json pendingStatistics;
+
+    static constexpr std::uint32_t CHECKPOINT_VERSION = 2;
+
+    // compactAnimals() iin eski indeks -> yeni indeks tablosu (admlar arasnda yeniden kullanlr)
+    std::vector<int> compactionMap;
+
+    // Adm verileri (threadPool == nullptr ise ayn adm kurallar aran i paracnda yrr)
+    ThreadPool* threadPool;
+    AnimalStore previousState;          // Hayvan gncellemesi srasnda komularn okunduu nceki durum
+    std::vector<StepIntent> intents;    // Hayvan bana, bakalarna yaplacak yazmalar
+
+    // Komu sorgularnn sonu tamponlar; her i paracna bir tane, admlar arasnda yeniden kullanlr.
+    struct QueryScratch {
+        std::vector<int> animals;
+        std::vector<Entity*> entities;
+        std::vector<Plant*> plants;
+    };
+
+    static QueryScratch& queryScratch() {
+        thread_local QueryScratch scratch;
+        return scratch;
+    }
+
+    // Verlet komu listeleri (bkz. setNeighbourSkin); 0: kapal, her hayvan her adm uzaysal indeksi sorgular
+    double neighbourSkin = 0;
+    std::vector<int> staleAnimals;      // Bu adm listesi yeniden kurulan hayvanlar
+    std::vector<char> staleFlag;        // Hayvan bana: staleAnimals iinde mi?
+
+public:
+    const SpeciesParameters& parameters;    // Tr tablolar; ortamdan uzun yaamal ve kou boyunca deimez
+    AnimalStore animals;
+    std::vector<Entity*> entities;
+    std::vector<Plant*> plants;         // entities iindeki bitkiler (tr dnm eklemede bir kez yaplr)
+
+    // Hayvanlarn zaman iinde konum kaytlar
+    std::map<int, std::vector<std::pair<double, double>>> animalPositions;
+
+    int lastAnimalID = 0;
+    BirthQueue birthQueue;
+
+    // Tm kt dosyalarn yazan arka plan yazcs (trajectory'den nce tanml: ondan sonra yok edilmeli)
+    OutputWriter output;
+
+    // Hayvanlarn adm bana deiken verileri (animal_dynamic_data.bin); main() iinde alp kapatlr
+    TrajectoryWriter trajectory;
+
+    // Adm evrelerinin sre lm (varsaylan: kapal); CSV dosyas output'a yazld iin ondan sonra tanml
+    StepProfiler profiler;
+
+    Environment(int w, int h, SpatialIndexType indexType = QuadTreeIndex,
+        const SpeciesParameters& speciesParameters = defaultSpeciesParameters)
+        : spatialIndex(nullptr), plantIndex(w, h, 40.0), width(w), height(h),
+          outputFormat(JsonArrayOutput), outputScale(0), plantKeyframeInterval(100), plantFoodTolerance(0),
+          nextPlantKeyframe(0), outputPath(basePath), threadPool(nullptr), parameters(speciesParameters)
+    {
+        recording.fill({ 1, 0, -1 });
+        setSpatialIndex(indexType);
+        animals.birthQueuePtr = &birthQueue;
+        animals.parameters = &parameters;
+        previousState.parameters = &parameters;
+    }
+
+    ~Environment() {
+        for (auto& entity : entities) {
+            delete entity;
+        }
+        delete spatialIndex;
+        delete threadPool;
+    }
+
+    /*
+        setThreadCount(), paralel admda kullanlacak i parac saysn ayarlar.
+        0 verilirse adm aran i paracnda yrr. Her iki durumda da ayn adm kurallar (nceki durum +
+        sral intent uygulamas) kullanlr; sonu ve checkpoint'ler i parac saysndan bamszdr.
+    */
+    void setThreadCount(int threads) {
+        delete threadPool;
+        threadPool = (threads > 0) ? new ThreadPool(threads) : nullptr;
+    }
+
+    /*
+        setOutputFormat(), JSON ktlarnn biimini ve ondalk hassasiyetini ayarlar.
+        precision, ondalk deerlerin virglden sonraki basamak saysdr (-1: tam hassasiyet).
+        Dosyalar almadan (clearFile) nce arlmaldr.
+    */
+    void setOutputFormat(OutputFormat format, int precision = -1) {
+        outputFormat = format;
+        outputScale = (precision >= 0) ? std::pow(10.0, precision) : 0;
+    }
+
+    OutputFormat getOutputFormat() const { return outputFormat; }
+
+    /*
+        setPlantOutput(), bitki verisinin ne sklkla tam yazlacan ayarlar.
+        keyframeInterval admda bir tm bitkilerin food deeri yazlr (anahtar kare); aradaki admlarda yalnzca
+        son yazlan deerinden tolerance'tan fazla uzaklaan bitkiler yazlr. 1: her adm anahtar karedir.
+    */
+    void setPlantOutput(int keyframeInterval, double tolerance) {
+        plantKeyframeInterval = std::max(keyframeInterval, 1);
+        plantFoodTolerance = tolerance;
+    }
+
+    /*
+        setRecording(), bir akn kayt araln ve penceresini ayarlar. rnein { 10, 5000, -1 },
+        snma sresinden (ilk 5000 adm) sonra her 10 admda bir kayt alr; { 0, 0, -1 } ak kapatr.
+    */
+    void setRecording(RecordingStream stream, RecordingWindow window) {
+        window.interval = std::max(window.interval, 0);
+        recording[stream] = window;
+    }
+
+    /*
+        setOutputPath(), update() ve doumlarn yazd dosyalarn (plant_data1.json, statistics.json,
+        animal_static_data.json) nekini ayarlar. Varsaylan: basePath. Ayn srete birden fazla ortam
+        alrken her birine ayr nek verilmelidir.
+    */
+    void setOutputPath(const std::string& path) {
+        outputPath = path;
+    }
+
+    const std::string& getOutputPath() const { return outputPath; }
+
+    /*
+        setSeed(), ortamn kk tohumunu ayarlar (varsaylan: global rngSeed). Hayvanlarn tm ekilileri
+        bu tohumdan tretilir; hayvanlar eklenmeden nce arlmaldr.
+    */
+    void setSeed(std::uint64_t seed) {
+        animals.seed = seed;
+    }
+
+    std::uint64_t getSeed() const { return animals.seed; }
+
+    /*
+        setSpatialIndex(), komu sorgularnda kullanlacak uzaysal indeksi deitirir.
+        ndeks her admda yeniden kurulduu iin simlasyonun herhangi bir annda arlabilir.
+    */
+    void setSpatialIndex(SpatialIndexType indexType) {
+        delete spatialIndex;
+        if (indexType == UniformGridIndex) {
+            // Balang hcre boyu; ilk rebuild'de en byk detection_range'e gre ayarlanr.
+            spatialIndex = new UniformGrid(width, height, 40.0, &animals);
+        }
+        else {
+            spatialIndex = new QuadTree(0, 0, 0, width, height, &animals, indexType == IncrementalQuadTreeIndex);
+        }
+    }
+
+    /*
+        setNeighbourSkin(), Verlet komu listelerini aar (skin > 0) veya kapatr (0). Akken her hayvann aday
+        komular detection_range + skin yarapyla listelenir ve hayvan, liste kurulduundan beri skin/2'den fazla
+        yer deitirene kadar her adm bu listeden szlr (bkz. refreshNeighbourLists). Adaylar her iki yolda da
+        depo srasyla deerlendirildiinden sonular skin deerinden (0 dahil) bamszdr.
+    */
+    void setNeighbourSkin(double skin) {
+        neighbourSkin = std::max(skin, 0.0);
+        animals.resetNeighbourLists();
+    }
+
+    double getNeighbourSkin() const { return neighbourSkin; }
+
+    /*
+        addAnimal(), hayvan AnimalStore'a ekler, hayvanPositions iin ID'ye uygun kayt aar.
+        Hayvann depodaki indeksini dndrr.
+    */
+    int addAnimal(int id, double x, double y, double speed, double detectionRange, int species,
+        double stealth, double detection)
+    {
+        int index = animals.add(id, x, y, speed, detectionRange, species, stealth, detection);
+        animalPositions[id] = {};
+        lastAnimalID++;
+        return index;
+    }
+
+    /*
+        removeAnimal(), hayvan l olarak iaretler; ona ait handle'lar hemen geersiz olur.
+        Satr, compactAnimals() arlana kadar depoda kalr.
+    */
+    void removeAnimal(int index) {
+        animals.kill(index);
+    }
+
+    /*
+        compactAnimals(), l iaretli hayvanlar depodan tek geite siler ve uzaysal indekse
+        yeni indeksleri bildirir. Her admda bir kez arlr.
+    */
+    void compactAnimals() {
+        if (animals.compact(compactionMap) > 0) {
+            spatialIndex->compactAnimals(compactionMap);
+        }
+    }
+
+    // animal(), depodaki index numaral hayvan iin bir grnm (view) dndrr.
+    Animal animal(int index) {
+        return Animal(&animals, index);
+    }
+
+    /*
+        addEntity(), bitki vb. Entity tiplerini ortama ekler.
+        Bitkiler statik bitki indeksine, dier entity'ler her adm gncellenen uzaysal indekse gider.
+    */
+    void addEntity(Entity* entity) {
+        entities.push_back(entity);
+        Plant* plant = dynamic_cast<Plant*>(entity);
+        if (plant) {
+            plants.push_back(plant);
+            plantIndex.addPlant(plant);
+        }
+        else {
+            dynamicEntities.push_back(entity);
+        }
+    }
+
+    /*
+        removeEntity(), entity'yi ortamdan karr ve siler (bitkiyse statik indeks de gncellenir).
+    */
+    void removeEntity(Entity* entity) {
+        entities.erase(std::remove(entities.begin(), entities.end(), entity), entities.end());
+        Plant* plant = dynamic_cast<Plant*>(entity);
+        if (plant) {
+            plants.erase(std::remove(plants.begin(), plants.end(), plant), plants.end());
+            plantIndex.removePlant(plant);
+        }
+        else {
+            dynamicEntities.erase(std::remove(dynamicEntities.begin(), dynamicEntities.end(), entity), dynamicEntities.end());
+        }
+        delete entity;
+    }
+
+    /*
+        TRKE:
+        processBirthQueue(), doum kuyruundan (birthQueue) yeni hayvanlar alr ve ortama ekler.
+    */
     void processBirthQueue() {
         while (birthQueue.hasPendingBirths()) {
             BirthQueue::BirthInfo birthInfo = birthQueue.dequeueBirth();
-            Animal* newAnimal = new Animal(
+            int newAnimal = addAnimal(
                 lastAnimalID,
                 birthInfo.x,
                 birthInfo.y,
@@ -1425,289 +4461,757 @@ public:
                 birthInfo.detectionRange,
                 birthInfo.species,
                 birthInfo.stealthLevel,
-                birthInfo.detectionSkill,
-                &animals,
-                &birthQueue
+                birthInfo.detectionSkill
             );
-            addAnimal(newAnimal);
-            saveAnimalStaticData(basePath + "animal_static_data.json", newAnimal);
+            if (recording[AnimalStaticStream].enabled()) {
+                saveAnimalStaticData(outputPath + "animal_static_data.json", newAnimal);
+            }
         }
     }
 
     /*
-        update(int i), her admda yaplan ilemler:
-         1) Baz verileri kaydet (animal_dynamic_data.json).
-         2) doum kuyruunu ile (processBirthQueue).
-         3) quadtree'yi temizle, tekrar doldur.
-         4) lm hayvanlar kar.
-         5) hayvanlarn update() metodunu ar.
-         6) quadtree'ye hayvanlar, entity'leri yerletir.
-         7) her hayvan iin detectAnimals ve detectPlants yap.
-         8) bitkilerin gda deerini artr (food_rej_per_step).
-         9) hayvanlarn koordinatlar snrn dna kyorsa mod alarak ieri sok.
-         10) bitki verilerini kaydet (savePlantData).
+        refreshNeighbourLists(), Verlet komu listelerini konumlar ilerledikten ve uzaysal indeks gncellendikten sonra
+        yeniler. Liste kurulurken hayvann konumu ve menzili referans olarak saklanr; listede, referans konumlar
+        arasndaki uzaklk referans menzil + skin'i amayan ilgili trden tm hayvanlar bulunur. Her hayvann
+        referansndan uzaklamas (menzil art dahil) skin/2'yi amadka, menzil iindeki her komu listededir.
+        Aan hayvanlar (ve yeni doanlar) "bayat"tr:
+         1) bayat hayvanlarn referans gncel konumlarna ekilir ve listeleri indeks sorgusuyla batan kurulur
+            (paralel arlabilir; her hayvan yalnzca kendi listesine yazar),
+         2) her bayat hayvan, yeni referansna gre listesinde olmas gereken dier hayvanlarn listelerine sral
+            olarak eklenir (tek i paracnda). Eskiden listede olup artk uzakta kalan kaytlar zararszdr;
+            alglama adaylar her adm gerek menzile gre szlr ve liste sahibi bayatladnda temizlenir.
+        Bayat hayvanlar poplasyonun 1/REBUILD_ALL_FRACTION'n aarsa tm listeler batan kurulur (2. adm gerekmez);
+        bayat hayvan bana iki geni sorgu yapldndan artml yenileme yalnzca az sayda bayat hayvanla krldr.
+        Snrdan sarlan hayvann konumu alan boyu kadar sradndan o hayvan bayatlar.
     */
-    void update(int i) {
-        if (i % 50 == 0) {
-            cout << "#################################### STEP: " << i << " ####################################\n\n";
+    void refreshNeighbourLists() {
+        const double SLACK = 1e-9;     // Kayan nokta yuvarlamasna kar listeleme pay
+        const int REBUILD_ALL_FRACTION = 8;
+        int count = static_cast<int>(animals.size());
+        double skin = neighbourSkin;
+
+        staleAnimals.clear();
+        staleFlag.assign(count, 0);
+        for (int index = 0; index < count; index++) {
+            double range = animals.detection_range[index];
+            double drift = std::hypot(animals.x[index] - animals.neighbourX[index], animals.y[index] - animals.neighbourY[index])
+                + std::max(0.0, range - animals.neighbourRange[index]);
+            if (animals.neighbourRange[index] < 0 || drift > skin / 2) {
+                staleAnimals.push_back(index);
+            }
+        }
+        bool rebuildAll = static_cast<int>(staleAnimals.size()) * REBUILD_ALL_FRACTION > count;
+        if (rebuildAll) {
+            staleAnimals.resize(count);
+            for (int index = 0; index < count; index++) {
+                staleAnimals[index] = index;
+            }
         }
 
-        saveAnimalDynamicData(basePath + "animal_dynamic_data.json", i);
-        processBirthQueue();
-
-        quadtree->clear();
+        for (int index : staleAnimals) {
+            staleFlag[index] = 1;
+            animals.neighbourX[index] = animals.x[index];
+            animals.neighbourY[index] = animals.y[index];
+            animals.neighbourRange[index] = animals.detection_range[index];
+        }
 
-        // lm hayvanlar sil
-        for (auto it = animals.begin(); it != animals.end(); /* bo */) {
-            Animal* animal = *it;
-            Animal* hisTarget = animal->getTarget();
+        // 1) Bayat hayvanlarn kendi listeleri. Bayat olmayanlarn gncel konumu referansndan en fazla skin/2 uzakta
+        //    olduundan sorgu o kadar geni yaplr (hepsi yeniden kuruluyorsa tm referanslar gncel konumdadr).
+        double queryMargin = rebuildAll ? 0.0 : skin / 2;
+        auto buildLists = [this, skin, SLACK, queryMargin](int begin, int end) {
+            QueryScratch& scratch = queryScratch();
+            for (int k = begin; k < end; k++) {
+                int index = staleAnimals[k];
+                double x = animals.neighbourX[index];
+                double y = animals.neighbourY[index];
+                double reach = animals.neighbourRange[index] + skin + SLACK;
+
+                scratch.animals.clear();
+                spatialIndex->retrieveAnimal(index, x, y, reach + queryMargin,
+                    parameters.foodChainMasks.relevant[animals.species[index]], scratch.animals);
+                std::vector<int>& list = animals.neighbours[index];
+                list.clear();
+                for (int other : scratch.animals) {
+                    if (std::hypot(animals.neighbourX[other] - x, animals.neighbourY[other] - y) <= reach) {
+                        list.push_back(other);
+                    }
+                }
+                std::sort(list.begin(), list.end());
+            }
+        };
+        if (threadPool) {
+            threadPool->parallelFor(static_cast<int>(staleAnimals.size()), buildLists);
+        }
+        else {
+            buildLists(0, static_cast<int>(staleAnimals.size()));
+        }
+        if (rebuildAll) {
+            return;
+        }
 
-            if (hisTarget != nullptr && hisTarget->getHealth() <= 0) {
-                animal->removeTarget(hisTarget);
+        // 2) Bayat hayvanlar, onu listelemesi gereken bayat olmayan hayvanlarn listelerine ekle
+        //    (tr ilikisi simetriktir: relevant[a]'da b varsa relevant[b]'de a vardr)
+        double maxReach = 0;
+        for (double range : animals.neighbourRange) {
+            maxReach = std::max(maxReach, range + skin + SLACK);
+        }
+        QueryScratch& scratch = queryScratch();
+        for (int index : staleAnimals) {
+            double x = animals.neighbourX[index];
+            double y = animals.neighbourY[index];
+            scratch.animals.clear();
+            spatialIndex->retrieveAnimal(index, x, y, maxReach + skin / 2,
+                parameters.foodChainMasks.relevant[animals.species[index]], scratch.animals);
+            for (int other : scratch.animals) {
+                if (staleFlag[other]
+                    || std::hypot(animals.neighbourX[other] - x, animals.neighbourY[other] - y)
+                        > animals.neighbourRange[other] + skin + SLACK) {
+                    continue;
+                }
+                std::vector<int>& list = animals.neighbours[other];
+                auto position = std::lower_bound(list.begin(), list.end(), index);
+                if (position == list.end() || *position != index) {
+                    list.insert(position, index);
+                }
             }
+        }
+    }
 
-            if (animal->getHealth() <= 0) {
-                // Dier hayvanlarn detected listelerinden de kar
-                for (auto& otherAnimal : animals) {
-                    if (otherAnimal != animal) {
-                        auto& detected = otherAnimal->detectedAnimals;
-                        detected.erase(std::remove(detected.begin(), detected.end(), animal), detected.end());
+    /*
+        detectRange(), [begin, end) aralndaki hayvanlar iin komu sorgusu ve alglama yapar.
+        Verlet listeleri aksa adaylar indeks yerine hayvann komu listesinden, indeksle ayn uzaklk testiyle szlr.
+        Adaylar her iki yolda da depo srasyla alglanr.
+        Her hayvan yalnzca kendi alglama listelerine ve kendi rastgele akna yazar; paralel arlabilir.
+    */
+    void detectRange(int begin, int end) {
+        QueryScratch& scratch = queryScratch();
+        for (int index = begin; index < end; index++) {
+            Animal animal(&animals, index);
+            double x = animals.x[index];
+            double y = animals.y[index];
+            double range = animals.detection_range[index];
+
+            scratch.animals.clear();
+            if (neighbourSkin > 0) {
+                for (int other : animals.neighbours[index]) {
+                    if (std::hypot(animals.x[other] - x, animals.y[other] - y) <= range) {
+                        scratch.animals.push_back(other);
                     }
                 }
-                string deadAnimalSpecies = animalNames[animal->getSpecies()];
-                int deadAnimalID = animal->getId();
-
-                it = animals.erase(it);
-                delete animal;
-
-                cout << "Hayvan ID: " << deadAnimalID << " (tur: " << deadAnimalSpecies << ") oldu.\n\n";
             }
             else {
-                ++it;
+                spatialIndex->retrieveAnimal(index, x, y, range, parameters.foodChainMasks.relevant[animals.species[index]], scratch.animals);
+                // Alglama zarlar aday srasyla atlr; depo sras, sonucu indeksin gezinme srasndan ve
+                // Verlet listelerinin ak/kapal olmasndan bamsz klar
+                std::sort(scratch.animals.begin(), scratch.animals.end());
             }
+            animal.detectAnimals(scratch.animals);
+
+            scratch.plants.clear();
+            plantIndex.retrievePlants(x, y, range, scratch.plants);
+            animal.detectPlants(scratch.plants);
         }
+    }
 
-        // Pozisyon kayd al ve hayvanlar gncelle
-        for (auto& animal : animals) {
-            double x = animal->getX();
-            double y = animal->getY();
-            int animalID = animal->getId();
-            animalPositions[animalID].emplace_back(x, y);
+    /*
+        updateAnimals(), hayvan gncellemesidir:
+         1) (kayt admysa) konumlar kaydet ve komularn grnen durumunu previousState'e kopyala,
+         2) her hayvan gncelle (paralel veya threadPool yoksa srayla; komular previousState'ten okunur,
+            bakalarna yazmalar intent'e gider),
+         3) intent'leri tek i paracnda hayvan srasyla uygula (saldr, yeme, iftleme, doum).
+    */
+    void updateAnimals(bool recordPositions) {
+        int count = static_cast<int>(animals.size());
+        for (int index = 0; recordPositions && index < count; index++) {
+            animalPositions[animals.id[index]].emplace_back(animals.x[index], animals.y[index]);
+        }
+        previousState.copyVisibleState(animals);
+        intents.assign(count, StepIntent());
 
-            animal->update();
+        auto updateRange = [this](int begin, int end) {
+            for (int index = begin; index < end; index++) {
+                Animal(&animals, index, &previousState, &intents[index]).update();
+            }
+        };
+        if (threadPool) {
+            threadPool->parallelFor(count, updateRange);
+        }
+        else {
+            updateRange(0, count);
         }
 
-        // Quadtree yeniden doldur
-        for (auto& animal : animals) {
-            quadtree->insertAnimal(animal);
+        for (int index = 0; index < count; index++) {
+            Animal(&animals, index).applyIntent(intents[index]);
         }
-        for (auto& entity : entities) {
-            quadtree->insertEntity(entity);
+    }
+
+    /*
+        moveAnimals(), hareket aamasdr: gncelleme srasnda moveForward() ile kaydedilen mesafeleri
+        tm hayvanlara tek geite uygular ve koordinatlar ayn geite dnya snrlar iine sarar.
+    */
+    void moveAnimals() {
+        moveAnimalsBatch(animals.x.data(), animals.y.data(), animals.angle.data(), animals.move_distance.data(),
+            static_cast<int>(animals.size()), width, height);
+    }
+
+    /*
+        update(int i), her admda yaplan ilemler:
+         1) Hayvanlarn adm verilerini kaydet (animal_dynamic_data.bin). Kaytlar aklarn pencerelerine uyar.
+         2) doum kuyruunu ile (processBirthQueue).
+         3) lm hayvanlar iaretle ve tek geite depodan kar (uzaysal indekse de bildirilir).
+         4) hayvanlarn update() metodunu ar (hareket kararlar move_distance'a yazlr).
+         5) hayvanlar tek geite ilerlet ve snrn dna kanlar ieri sar (moveAnimals).
+         6) uzaysal indeksi gncelle (yeniden kur veya artml olarak gncelle); Verlet listeleri aksa bayatlayanlar yenile.
+         7) her hayvan iin detectAnimals ve detectPlants yap.
+         8) bitkilerin gda deerini artr (food_rej_per_step).
+         9) bitki verilerini kaydet (savePlantData).
+        Adm istatistikleri, hayvanlar iin admn banda (trajectory kaydyla ayn anda), bitkiler iin admn
+        sonunda (bitki kaydyla ayn anda) toplanr. profiler aksa her evrenin sresi ayrca llr.
+    */
+    void update(int i) {
+        if (logEvents && i % 50 == 0) {
+            cout << "#################################### STEP: " << i << " ####################################\n\n";
         }
 
-        // Her hayvan, alg menzilindeki hayvan ve bitkileri belirlesin
-        for (auto& animal : animals) {
-            animal->detectAnimals(quadtree->retrieveAnimal(animal, animal->getX(), animal->getY(), animal->getRange()));
-
-            std::vector<Entity*> entitiesInRange = quadtree->retrieveEntity(animal->getX(), animal->getY(), animal->getRange());
-            std::vector<Plant*> plantsInRange;
-            for (auto* entity : entitiesInRange) {
-                Plant* plant = dynamic_cast<Plant*>(entity);
-                if (plant) {
-                    plantsInRange.push_back(plant);
+        profiler.beginStep();
+        animals.beginStep(i);
+        bool recordStatistics = recording[StatisticsStream].contains(i);
+        if (recordStatistics) {
+            collectStatistics(i);
+        }
+        profiler.mark(StepProfiler::CollectStatisticsPhase);
+        if (recording[AnimalTrajectoryStream].contains(i)) {
+            saveAnimalDynamicData(i);
+        }
+        profiler.mark(StepProfiler::SaveTrajectoryPhase);
+        processBirthQueue();
+        profiler.mark(StepProfiler::BirthPhase);
+
+        // lm hayvanlar iaretle (onlar hedefleyenlerin handle'lar bylece geersiz olur), sonra tek geite sil
+        for (int index = 0; index < static_cast<int>(animals.size()); index++) {
+            if (animals.health[index] <= 0) {
+                removeAnimal(index);
+                if (logEvents) {
+                    cout << "Hayvan ID: " << animals.id[index] << " (tur: " << parameters.names[animals.species[index]] << ") oldu.\n\n";
                 }
             }
-            animal->detectPlants(plantsInRange);
         }
+        compactAnimals();
+        profiler.mark(StepProfiler::RemoveDeadPhase);
 
-        // Bitkiler, her adm food_rej_per_step kadar kendini yeniler
-        std::vector<Plant*> plants;
-        for (auto* entity : entities) {
-            Plant* plant = dynamic_cast<Plant*>(entity);
-            if (plant) {
-                plants.push_back(plant);
-            }
+        // Pozisyon kayd al ve hayvanlar gncelle
+        bool recordPositions = recording[PositionHistoryStream].contains(i);
+        updateAnimals(recordPositions);
+        profiler.mark(StepProfiler::AnimalUpdatePhase);
+
+        // Hayvanlar bu admn mesafesi kadar ilerlet ve ortam snrn aanlar dndr
+        moveAnimals();
+        profiler.mark(StepProfiler::MovementPhase);
+
+        // Uzaysal indeksi gncel konumlara getir (bitkiler statik indekste olduundan eklenmez)
+        spatialIndex->update(static_cast<int>(animals.size()), dynamicEntities);
+        profiler.mark(StepProfiler::IndexBuildPhase);
+        if (neighbourSkin > 0) {
+            refreshNeighbourLists();
+        }
+        profiler.mark(StepProfiler::NeighbourListPhase);
+
+        // Her hayvan, alg menzilindeki hayvan ve bitkileri belirlesin
+        if (threadPool) {
+            plantIndex.prepare();
+            threadPool->parallelFor(static_cast<int>(animals.size()), [this](int begin, int end) {
+                detectRange(begin, end);
+            });
+        }
+        else {
+            detectRange(0, static_cast<int>(animals.size()));
         }
+        profiler.mark(StepProfiler::DetectionPhase);
+
+        // Bitkiler, her adm foodRejuvenation (food_rej_per_step) kadar kendini yeniler
         for (auto* plant : plants) {
             if (plant->getFood() < plant->getMaxFood()) {
-                plant->setFood(plant->getFood() + food_rej_per_step);
+                plant->setFood(plant->getFood() + parameters.foodRejuvenation);
             }
         }
+        profiler.mark(StepProfiler::PlantRegrowthPhase);
 
-        // Hayvanlar ortam snrn aarsa, mod alma ile dndr
-        for (auto& animal : animals) {
-            double x = animal->getX();
-            double y = animal->getY();
-            x = fmod(x + width, width);
-            y = fmod(y + height, height);
-            animal->setX(x);
-            animal->setY(y);
+        if (recording[PlantStream].contains(i)) {
+            savePlantData(outputPath + "plant_data1.json", i);
         }
-
-        savePlantData(basePath + "plant_data1.json", i);
+        profiler.mark(StepProfiler::SavePlantsPhase);
+        if (recordStatistics) {
+            saveStatistics(outputPath + "statistics.json");
+        }
+        profiler.mark(StepProfiler::SaveStatisticsPhase);
+        profiler.endStep(i, static_cast<int>(animals.size()));
         //exportData(basePath + "quadtree_data1.json", i); // Opsiyonel
     }
 
     /*
-        exportData(), quadtree yapsn JSON'a kaydeder.
+        exportData(), uzaysal indeks yapsn (quadtree dmleri veya zgara) JSON'a kaydeder.
         Bu rnekte pasif konumdadr (isteyen aabilir).
     */
-    void exportData(const std::string& filename, int frame) const {
-        static bool firstFrame = true;
+    void exportData(const std::string& filename, int frame) {
         json frame_data;
 
-        quadtree->exportQuadTree(frame_data);
+        spatialIndex->exportIndex(frame_data);
 
         json step_entry;
         step_entry["frame"] = frame;
         step_entry["quadtree"] = frame_data;
 
-        std::ofstream file(filename, std::ios::app);
-        if (file.is_open()) {
-            if (firstFrame) {
-                file << "";
-                firstFrame = false;
-            }
-            else {
-                file << ",";
-            }
-            file << step_entry.dump(4);
-            file.close();
+        output.write(filename, serializeRecord(step_entry, isFirstIndexWrite));
+    }
+
+    // Ondalk deeri kt hassasiyetine yuvarlar
+    double outputValue(double value) const {
+        return (outputScale > 0) ? std::round(value * outputScale) / outputScale : value;
+    }
+
+    /*
+        serializeRecord(), bir kayd seili biimde metne evirir. JSON dizisi biiminde ilk kayt dndakilerin
+        nne "," eklenir; NDJSON biiminde her kayt tek satrdr.
+    */
+    std::string serializeRecord(const json& record, bool& isFirst) const {
+        if (outputFormat == NdjsonOutput) {
+            return record.dump() + "\n";
         }
+        std::string text = isFirst ? "\n" : ",\n";
+        isFirst = false;
+        text += record.dump(4);
+        return text;
     }
 
     /*
         saveAnimalStaticData(), yeni doan hayvanlarn sabit zelliklerini
         (r. species, is_herbivore, speed vb.) JSON dosyasna ekler.
     */
-    void saveAnimalStaticData(const std::string& filename, const Animal* newAnimal) const {
-        static bool isFirstStaticWrite = true;
-
+    void saveAnimalStaticData(const std::string& filename, int newAnimal) {
+        int species = animals.species[newAnimal];
         json animalData;
-        animalData["id"] = newAnimal->getId();
-        animalData["species"] = newAnimal->getSpecies();
-        animalData["species_name"] = animalNames[newAnimal->getSpecies()];
-        animalData["is_herbivore"] = foodChainMatrix[newAnimal->getSpecies()][NUM_ANIMALS];
-        animalData["speed"] = newAnimal->getSpeed();
-        animalData["stealth_level"] = newAnimal->getStealthLevel();
-        animalData["detection_skill"] = newAnimal->getDetectionSkill();
-        animalData["detection_range"] = newAnimal->getRange();
-
-        std::ofstream file(filename, std::ios_base::app);
-        if (file.is_open()) {
-            if (isFirstStaticWrite) {
-                file << "\n";
-                isFirstStaticWrite = false;
+        animalData["id"] = animals.id[newAnimal];
+        animalData["species"] = species;
+        animalData["species_name"] = parameters.names[species];
+        animalData["is_herbivore"] = parameters.foodChainMatrix[species][NUM_ANIMALS];
+        animalData["speed"] = outputValue(animals.birth_speed[newAnimal]);
+        animalData["stealth_level"] = outputValue(animals.birth_stealth[newAnimal]);
+        animalData["detection_skill"] = outputValue(animals.birth_detection[newAnimal]);
+        animalData["detection_range"] = outputValue(animals.detection_range[newAnimal]);
+
+        output.write(filename, serializeRecord(animalData, isFirstStaticWrite));
+    }
+
+    /*
+        saveAnimalDynamicData(), her admda hayvanlarn deiken verilerini
+        (x, y, health, hunger, state vb.) ikili trajectory dosyasna ekler (bkz. TrajectoryWriter).
+    */
+    void saveAnimalDynamicData(int frame) {
+        trajectory.writeStep(frame, animals);
+    }
+
+    /*
+        savePlantStaticData(), bitkilerin deimeyen verilerini (id, x, y, maxFood) bir kez JSON'a yazar.
+        id, bitkinin plants iindeki srasdr; savePlantData() bitkileri bu id ile anar.
+    */
+    void savePlantStaticData(const std::string& filename) {
+        for (size_t i = 0; i < plants.size(); i++) {
+            json plantData;
+            plantData["id"] = i;
+            plantData["x"] = outputValue(plants[i]->getX());
+            plantData["y"] = outputValue(plants[i]->getY());
+            plantData["maxFood"] = outputValue(plants[i]->getMaxFood());
+            output.write(filename, serializeRecord(plantData, isFirstPlantStaticWrite));
+        }
+    }
+
+    /*
+        savePlantData(), her admda bitkilerin food deerlerini JSON'a ekler: {"step", "keyframe", "id": [...], "food": [...]}.
+        Anahtar karelerde tm bitkiler, aradakilerde yalnzca food deeri plantFoodTolerance'tan fazla deienler yazlr.
+        Anahtar kareler en az plantKeyframeInterval adm arayla, kaydedilen admlara denk gelecek ekilde seilir.
+        Okuyucu bir admn durumunu son anahtar kareden itibaren kaytlar srayla uygulayarak kurar.
+    */
+    void savePlantData(const std::string& filename, int step) {
+        bool keyframe = step >= nextPlantKeyframe || writtenPlantFood.size() != plants.size();
+        writtenPlantFood.resize(plants.size());
+        if (keyframe) {
+            nextPlantKeyframe = step + plantKeyframeInterval;
+        }
+
+        json stepData;
+        stepData["step"] = step;
+        stepData["keyframe"] = keyframe;
+        json& ids = stepData["id"] = json::array();
+        json& foods = stepData["food"] = json::array();
+
+        for (size_t i = 0; i < plants.size(); i++) {
+            double food = plants[i]->getFood();
+            if (keyframe || std::abs(food - writtenPlantFood[i]) > plantFoodTolerance) {
+                ids.push_back(i);
+                foods.push_back(outputValue(food));
+                writtenPlantFood[i] = food;
+            }
+        }
+
+        output.write(filename, serializeRecord(stepData, isFirstPlantWrite));
+    }
+
+    /*
+        collectStatistics(), hayvan istatistiklerini tek geite toplar:
+        otul/etil saylar ve ortalama alk/salklar, tr bana nfus ve doumdaki ortalama
+        gizlilik, alglama becerisi ve hz. Kayt saveStatistics() ile adm sonunda yazlr.
+    */
+    void collectStatistics(int step) {
+        int population[NUM_ANIMALS] = {};
+        double stealth[NUM_ANIMALS] = {};
+        double detection[NUM_ANIMALS] = {};
+        double speed[NUM_ANIMALS] = {};
+        int herbivores = 0, carnivores = 0;
+        double herbivoreHunger = 0, herbivoreHealth = 0, carnivoreHunger = 0, carnivoreHealth = 0;
+
+        for (size_t i = 0; i < animals.size(); i++) {
+            int species = animals.species[i];
+            if (parameters.isHerbivore(species)) {
+                herbivores++;
+                herbivoreHunger += animals.hunger[i];
+                herbivoreHealth += animals.health[i];
             }
             else {
-                file << ",\n";
+                carnivores++;
+                carnivoreHunger += animals.hunger[i];
+                carnivoreHealth += animals.health[i];
             }
-            file << std::setw(4) << animalData;
-            file.close();
+            population[species]++;
+            stealth[species] += animals.birth_stealth[i];
+            detection[species] += animals.birth_detection[i];
+            speed[species] += animals.birth_speed[i];
         }
-        else {
-            std::cerr << "Dosya acma hatasi (static data): " << filename << std::endl;
+
+        json& stats = pendingStatistics = json::object();
+        stats["step"] = step;
+        stats["herbivores"] = herbivores;
+        stats["carnivores"] = carnivores;
+        stats["herbivore_hunger"] = outputValue(herbivores ? herbivoreHunger / herbivores : 0);
+        stats["herbivore_health"] = outputValue(herbivores ? herbivoreHealth / herbivores : 0);
+        stats["carnivore_hunger"] = outputValue(carnivores ? carnivoreHunger / carnivores : 0);
+        stats["carnivore_health"] = outputValue(carnivores ? carnivoreHealth / carnivores : 0);
+
+        json& species = stats["species"] = json::object();
+        for (int j = 0; j < NUM_ANIMALS; j++) {
+            if (population[j] > 0) {
+                json& entry = species[parameters.names[j]];
+                entry["population"] = population[j];
+                entry["stealth_level"] = outputValue(stealth[j] / population[j]);
+                entry["detection_skill"] = outputValue(detection[j] / population[j]);
+                entry["speed"] = outputValue(speed[j] / population[j]);
+            }
         }
     }
 
     /*
-        saveAnimalDynamicData(), her admda hayvanlarn deiken verilerini
-        (x, y, health, hunger, state vb.) JSON dosyasna ekler.
-    */
-    void saveAnimalDynamicData(const std::string& filename, int frame) const {
-        static bool isFirstDynamicWrite = true;
-        json frameData;
-        frameData["step"] = frame;
-        frameData["data"] = json::array();
-
-        for (const auto& animal : animals) {
-            json animalData;
-            animalData["id"] = animal->getId();
-            animalData["x"] = animal->getX();
-            animalData["y"] = animal->getY();
-            animalData["health"] = animal->getHealth();
-            animalData["hunger"] = animal->getHunger();
-            animalData["state"] = animal->getState();
-            frameData["data"].push_back(animalData);
-        }
-
-        std::ofstream file(filename, std::ios_base::app);
-        if (file.is_open()) {
-            if (isFirstDynamicWrite) {
-                file << "\n";
-                isFirstDynamicWrite = false;
+        saveStatistics(), collectStatistics() ile hazrlanan kayda bitkilerin ortalama food deerini
+        ekleyip istatistik dosyasna yazar.
+    */
+    void saveStatistics(const std::string& filename) {
+        double totalFood = 0;
+        for (const auto* plant : plants) {
+            totalFood += plant->getFood();
+        }
+        pendingStatistics["plant_food"] = outputValue(plants.empty() ? 0 : totalFood / plants.size());
+
+        output.write(filename, serializeRecord(pendingStatistics, isFirstStatisticsWrite));
+    }
+
+    /*
+        saveCheckpoint(), ortamn adm nextStep'ten devam etmek iin gereken tm durumunu ikili bir dosyaya yazar:
+        balk (boyutlar, adm, tohum, lastAnimalID), bitkiler, doum kuyruu ve hayvan deposunun tm
+        stunlar (gebelik/Womb, hedef handle'lar, bekleme sreleri, alglama listeleri) ile slot tablosu.
+        Rastgele saylar saya tabanl olduu iin RNG durumu ortamn tohumu ve adm numarasndan ibarettir.
+        Yalnzca kayt amal veriler (animalPositions, kt dosyalarnn durumu) yazlmaz.
+        Dosya dzeni:
+          Balk (48 bayt):
+            char     magic[8]       "ABMCKPT\0"
+            uint32   version        2 (srm 2: depo tablolarna move_distance stunu eklendi)
+            uint32   headerSize     48
+            int32    width, height
+            int64    nextStep
+            uint64   seed
+            int32    lastAnimalID
+            int32    NUM_ANIMALS
+          Ardndan BinaryWriter dizileri: bitkiler (x, y, size, maxFood, food), doum kuyruu (species, 6'l
+          double kaytlar), AnimalStore::forEachTable() srasyla depo tablolar (move_distance dahil) ve uzaysal
+          indeksin saveState() ile yazlm durumu (bayt dizisi; yoksa bo).
+    */
+    bool saveCheckpoint(const std::string& filename, long long nextStep) {
+        if (!dynamicEntities.empty()) {
+            std::cerr << "Checkpoint yazilamadi: bitki disindaki entity'ler kaydedilemez." << std::endl;
+            return false;
+        }
+
+        std::ofstream file(filename, std::ios_base::binary | std::ios_base::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Dosya acma hatasi (checkpoint): " << filename << std::endl;
+            return false;
+        }
+        BinaryWriter out(file);
+
+        const char magic[8] = { 'A', 'B', 'M', 'C', 'K', 'P', 'T', '\0' };
+        out.bytes(magic, 8);
+        out.value(static_cast<std::uint32_t>(CHECKPOINT_VERSION));
+        out.value(static_cast<std::uint32_t>(48));
+        out.value(static_cast<std::int32_t>(width));
+        out.value(static_cast<std::int32_t>(height));
+        out.value(static_cast<std::int64_t>(nextStep));
+        out.value(static_cast<std::uint64_t>(animals.seed));
+        out.value(static_cast<std::int32_t>(lastAnimalID));
+        out.value(static_cast<std::int32_t>(NUM_ANIMALS));
+
+        // Bitkiler (entities iindeki srayla; alglama listeleri bitkileri bu sradaki indeksleriyle saklar)
+        std::vector<double> plantX, plantY, plantSize, plantMaxFood, plantFood;
+        std::map<const Plant*, int> plantIds;
+        for (const auto* plant : plants) {
+            plantIds[plant] = static_cast<int>(plantX.size());
+            plantX.push_back(plant->getX());
+            plantY.push_back(plant->getY());
+            plantSize.push_back(plant->getSize());
+            plantMaxFood.push_back(plant->getMaxFood());
+            plantFood.push_back(plant->getFood());
+        }
+        out.array(plantX);
+        out.array(plantY);
+        out.array(plantSize);
+        out.array(plantMaxFood);
+        out.array(plantFood);
+
+        // Doum kuyruu (kuyruk sras korunur)
+        std::vector<std::int32_t> birthSpecies;
+        std::vector<double> birthValues;
+        std::queue<BirthQueue::BirthInfo> pending = birthQueue.birthQueue;
+        while (!pending.empty()) {
+            const BirthQueue::BirthInfo& birth = pending.front();
+            birthSpecies.push_back(birth.species);
+            birthValues.insert(birthValues.end(), { birth.x, birth.y, birth.speed, birth.detectionRange,
+                birth.stealthLevel, birth.detectionSkill });
+            pending.pop();
+        }
+        out.array(birthSpecies);
+        out.array(birthValues);
+
+        // Hayvan deposu
+        animals.forEachTable([&out, &plantIds](auto& column) {
+            using Element = typename std::decay_t<decltype(column)>::value_type;
+            if constexpr (std::is_same<Element, std::vector<int>>::value) {
+                out.ragged(column, [](int other) { return other; });
+            }
+            else if constexpr (std::is_same<Element, std::vector<Plant*>>::value) {
+                out.ragged(column, [&plantIds](Plant* plant) { return plantIds.at(plant); });
+            }
+            else if constexpr (std::is_same<Element, std::vector<Entity*>>::value) {
+                // Bitki d entity yok; alglanan entity'ler bitkilerdir
+                out.ragged(column, [&plantIds](Entity* entity) { return plantIds.at(static_cast<Plant*>(entity)); });
+            }
+            else {
+                out.array(column);
+            }
+        });
+
+        // Uzaysal indeksin gemie bal durumu (yalnzca artml QuadTree'de vardr; dierleri yklemede kurulur)
+        std::ostringstream indexStream(std::ios_base::binary);
+        BinaryWriter indexOut(indexStream);
+        std::string indexState = spatialIndex->saveState(indexOut) ? indexStream.str() : std::string();
+        out.array(std::vector<char>(indexState.begin(), indexState.end()));
+
+        if (!out.good()) {
+            std::cerr << "Dosya yazma hatasi (checkpoint): " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /*
+        loadCheckpoint(), saveCheckpoint() ile yazlm bir dosyadan ortam geri ykler ve devam edilecek
+        adm nextStep'e yazar. Mevcut hayvanlar, bitkiler ve doum kuyruu atlr; ortamn tohumu dosyadakiyle deiir.
+        Dosya geersizse false dner ve ortam hi deimez.
+        Ayarlar (uzaysal indeks tr, i parac says, kt ayarlar) dosyada tutulmaz, arannkiler geerlidir.
+        Ayn ayarlarla devam eden kou, hi durmam kouyla bit bit ayndr (artml QuadTree'nin durumu da
+        dosyadadr). Farkl bir uzaysal indeksle devam edilirse indeks gncel konumlardan kurulur.
+    */
+    bool loadCheckpoint(const std::string& filename, int& nextStep) {
+        std::ifstream file(filename, std::ios_base::binary);
+        if (!file.is_open()) {
+            std::cerr << "Dosya acma hatasi (checkpoint): " << filename << std::endl;
+            return false;
+        }
+        file.seekg(0, std::ios_base::end);
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0, std::ios_base::beg);
+        if (fileSize < 0 || !file) {
+            std::cerr << "Dosya okuma hatasi (checkpoint): " << filename << std::endl;
+            return false;
+        }
+        BinaryReader in(file, static_cast<std::uint64_t>(fileSize));
+
+        char magic[8];
+        std::uint32_t version = 0, headerSize = 0;
+        std::int32_t fileWidth = 0, fileHeight = 0, fileLastAnimalID = 0, speciesCount = 0;
+        std::int64_t fileStep = 0;
+        std::uint64_t fileSeed = 0;
+        in.bytes(magic, 8);
+        in.value(version);
+        in.value(headerSize);
+        in.value(fileWidth);
+        in.value(fileHeight);
+        in.value(fileStep);
+        in.value(fileSeed);
+        in.value(fileLastAnimalID);
+        in.value(speciesCount);
+        // Adm numaras arann int adm sayacna smal (RNG sayac ve kayt pencereleri bu admdan devam eder)
+        if (!in.good() || std::string(magic, 7) != "ABMCKPT" || version != CHECKPOINT_VERSION || headerSize != 48 ||
+            fileStep < 0 || fileStep > INT_MAX)
+        {
+            std::cerr << "Gecersiz checkpoint dosyasi: " << filename << std::endl;
+            return false;
+        }
+        if (fileWidth != width || fileHeight != height || speciesCount != NUM_ANIMALS) {
+            std::cerr << "Checkpoint bu ortamla uyumsuz (boyut veya tur sayisi farkli): " << filename << std::endl;
+            return false;
+        }
+
+        std::vector<double> plantX, plantY, plantSize, plantMaxFood, plantFood;
+        in.array(plantX);
+        in.array(plantY);
+        in.array(plantSize);
+        in.array(plantMaxFood);
+        in.array(plantFood);
+
+        std::vector<std::int32_t> birthSpecies;
+        std::vector<double> birthValues;
+        in.array(birthSpecies);
+        in.array(birthValues);
+
+        size_t plantCount = plantX.size();
+        if (!in.good() || plantY.size() != plantCount || plantSize.size() != plantCount ||
+            plantMaxFood.size() != plantCount || plantFood.size() != plantCount ||
+            birthValues.size() != birthSpecies.size() * 6)
+        {
+            std::cerr << "Gecersiz checkpoint dosyasi: " << filename << std::endl;
+            return false;
+        }
+        for (std::int32_t species : birthSpecies) {
+            if (species < 0 || species >= NUM_ANIMALS) {
+                std::cerr << "Gecersiz checkpoint dosyasi: " << filename << std::endl;
+                return false;
+            }
+        }
+
+        // Dosyann tamam nce geici yaplara okunur; ortam yalnzca dorulama baarl olursa deitirilir.
+        // Bitkiler dosyadaki srayla kurulur (alglama listeleri bitkileri bu sradaki indeksleriyle saklar).
+        std::vector<std::unique_ptr<Plant>> loadedPlants;
+        for (size_t i = 0; i < plantCount; i++) {
+            loadedPlants.emplace_back(new Plant(plantX[i], plantY[i], plantSize[i], plantMaxFood[i]));
+            loadedPlants.back()->setFood(plantFood[i]);
+        }
+
+        // Hayvan deposu
+        AnimalStore loaded;
+        bool validIndices = true;
+        loaded.forEachTable([&in, &validIndices, &loadedPlants](auto& column) {
+            using Element = typename std::decay_t<decltype(column)>::value_type;
+            auto plantAt = [&validIndices, &loadedPlants](std::int32_t id) -> Plant* {
+                if (id < 0 || id >= static_cast<std::int32_t>(loadedPlants.size())) {
+                    validIndices = false;
+                    return nullptr;
+                }
+                return loadedPlants[id].get();
+            };
+            if constexpr (std::is_same<Element, std::vector<int>>::value) {
+                in.ragged(column, [](std::int32_t other) { return static_cast<int>(other); });
+            }
+            else if constexpr (std::is_same<Element, std::vector<Plant*>>::value) {
+                in.ragged(column, plantAt);
+            }
+            else if constexpr (std::is_same<Element, std::vector<Entity*>>::value) {
+                in.ragged(column, [&plantAt](std::int32_t id) -> Entity* { return plantAt(id); });
             }
             else {
-                file << ",\n";
+                in.array(column);
             }
-            file << std::setw(4) << frameData;
-            file.close();
+        });
+
+        std::vector<char> indexState;
+        in.array(indexState);
+        loaded.resetNeighbourLists();
+
+        if (!in.good() || !validIndices || !loaded.isConsistent()) {
+            std::cerr << "Gecersiz checkpoint dosyasi (hayvan verisi): " << filename << std::endl;
+            return false;
         }
-        else {
-            std::cerr << "Dosya acma hatasi (dynamic data): " << filename << std::endl;
+
+        // Dorulama tamam: bitkiler, doum kuyruu ve hayvanlar yklenen verilerle deitirilir
+        while (!entities.empty()) {
+            removeEntity(entities.back());
+        }
+        for (auto& plant : loadedPlants) {
+            addEntity(plant.release());
         }
-    }
 
-    /*
-        savePlantData(), her admda bitkilerin (food) deerlerini JSON'a ekler.
-    */
-    void savePlantData(const std::string& filename, int step) const {
-        static bool isFirstPlantWrite = true;
-        json stepData;
-        stepData["step"] = step;
-        stepData["plants"] = json::array();
+        birthQueue.birthQueue = std::queue<BirthQueue::BirthInfo>();
+        for (size_t i = 0; i < birthSpecies.size(); i++) {
+            const double* v = &birthValues[i * 6];
+            birthQueue.enqueueBirth(birthSpecies[i], v[0], v[1], v[2], v[3], v[4], v[5]);
+        }
 
-        for (const auto& entity : entities) {
-            const Plant* plant = dynamic_cast<const Plant*>(entity);
-            if (plant) {
-                json plantData;
-                plantData["x"] = plant->getX();
-                plantData["y"] = plant->getY();
-                plantData["food"] = plant->getFood();
-                stepData["plants"].push_back(plantData);
-            }
+        // Depo nesnesi yerinde kalr (uzaysal indeks ona iaret eder); yalnzca tablolar tanr
+        loaded.currentStep = animals.currentStep;
+        loaded.birthQueuePtr = animals.birthQueuePtr;
+        loaded.parameters = animals.parameters;
+        animals = std::move(loaded);
+
+        animals.seed = fileSeed;
+        lastAnimalID = fileLastAnimalID;
+        nextStep = static_cast<int>(fileStep);
+
+        // Konum gemii checkpoint'te yoktur; yklenen hayvanlar iin bo kayt alr
+        animalPositions.clear();
+        for (int id : animals.id) {
+            animalPositions[id] = {};
         }
 
-        std::ofstream file(filename, std::ios_base::app);
-        if (file.is_open()) {
-            if (isFirstPlantWrite) {
-                file << "\n";
-                isFirstPlantWrite = false;
-            }
-            else {
-                file << ",\n";
-            }
-            file << std::setw(4) << stepData;
-            file.close();
+        // Uzaysal indeks: saklanan durum bu indekse aitse yklenir, deilse gncel konumlardan kurulur
+        bool indexLoaded = false;
+        if (!indexState.empty()) {
+            std::istringstream indexStream(std::string(indexState.begin(), indexState.end()), std::ios_base::binary);
+            BinaryReader indexIn(indexStream, indexState.size());
+            indexLoaded = spatialIndex->loadState(indexIn, static_cast<int>(animals.size())) && indexIn.good();
         }
-        else {
-            std::cerr << "Dosya acma hatasi (bitki verisi): " << filename << std::endl;
+        if (!indexLoaded) {
+            spatialIndex->rebuild(static_cast<int>(animals.size()), dynamicEntities);
         }
+
+        // Bitki kts yeni dosyada anahtar kareyle balar
+        writtenPlantFood.clear();
+        nextPlantKeyframe = 0;
+        return true;
     }
 
     /*
-        finalizeExport(), JSON dizisini kapatmak gibi son ilemleri yapar.
+        finalizeExport(), JSON dizisini kapatr (NDJSON biiminde kapatlacak bir ey yoktur) ve dosyay kapatr.
     */
-    void finalizeExport(const std::string& filename) const {
-        std::ofstream file(filename, std::ios_base::app);
-        if (file.is_open()) {
-            file << "\n]";
-            file.close();
-        }
-        else {
-            std::cerr << "Dosya acma hatasi (finalize): " << filename << std::endl;
+    void finalizeExport(const std::string& filename) {
+        if (outputFormat == JsonArrayOutput) {
+            output.write(filename, "\n]");
         }
+        output.close(filename);
     }
 
     /*
-        clearFile(), verilen dosyay sfrlar (iini siler)
-        ve JSON dizisine balamak iin "[" karakterini yazar.
+        clearFile(), verilen dosyay sfrlar (iini siler), kou boyunca ak tutar
+        ve JSON dizisi biiminde diziye balamak iin "[" karakterini yazar.
     */
     void clearFile(const std::string& filePath) {
-        std::ofstream file(filePath, std::ofstream::out | std::ofstream::trunc);
-        if (file.is_open()) {
-            file << "[";
-            file.close();
+        output.open(filePath);
+        if (outputFormat == JsonArrayOutput) {
+            output.write(filePath, "[");
         }
     }
 };
@@ -1722,32 +5226,20 @@ public:
      - Adm sonunda veriler JSON dosyalarna yazlr.
      - Simlasyon bitince Python scripti arlabilir.
 */
-int main() {
-
-    //ios_base::sync_with_stdio(false);
-
-    int width = 500;
-    int height = 500;
-    int steps = 55000;
-    int offset = 222;
-
-    Environment env(width, height);
-
-    int numAnimals = 50;
-    int numEntities = 50;
-
-    // Verilerin kaydedilecei JSON dosyalarn temizle (balang ayarlar).
-    env.clearFile(basePath + "plant_data1.json");
-    env.clearFile(basePath + "quadtree_data1.json");
-    env.clearFile(basePath + "animal_static_data.json");
-    env.clearFile(basePath + "animal_dynamic_data.json");
-
-    std::mt19937 mt(time(nullptr));
+/*
+    populateEnvironment(), ortama balang hayvan poplasyonunu (ortamn tr arlklar dalmyla) ve bitkileri ekler.
+    Tm ekililer ortamn tohumundan tretilir; ayn tohum ayn balang durumunu verir.
+*/
+void populateEnvironment(Environment& env, int width, int height, int numAnimals, int numEntities, int offset) {
+    // Balang poplasyonu ve bitkiler iin kurulum ak
+    std::uint32_t setupDraws = 0;
+    CounterRng mt{ env.getSeed(), 0, RNG_SETUP_DOMAIN, 0, setupDraws };
 
     // Arlk dalm (probabilityRanges) oluturma
     std::vector<int> probablityRanges;
     probablityRanges.push_back(0);
-    for (int weight : animalSpeciesWeights) {
+    const SpeciesParameters& parameters = env.parameters;
+    for (int weight : parameters.speciesWeights) {
         probablityRanges.push_back(probablityRanges.back() + weight);
     }
     int sum = probablityRanges.back();
@@ -1763,19 +5255,19 @@ int main() {
             }
         }
 
-        double baseSpeed = 0.6 + (std::mt19937{ std::random_device{}() }() % 100) / 130.0;
+        double baseSpeed = 0.6 + mt.below(100) / 130.0;
         double baseDetectionRange = 40;
-        double baseStealth = (std::mt19937{ std::random_device{}() }() % 100) / 400.0;
-        double baseDetection = (std::mt19937{ std::random_device{}() }() % 100) / 400.0;
+        double baseStealth = mt.below(100) / 400.0;
+        double baseDetection = mt.below(100) / 400.0;
 
         // Tr arpanlarn uygula
-        double speciesSpeed = baseSpeed * animalTemplates[species].speed;
-        double speciesDetectionRange = baseDetectionRange * animalTemplates[species].detectionRange;
-        double speciesStealth = baseStealth * animalTemplates[species].stealthLevel;
-        double speciesDetection = baseDetection * animalTemplates[species].detectionSkill;
+        double speciesSpeed = baseSpeed * parameters.templates[species].speed;
+        double speciesDetectionRange = baseDetectionRange * parameters.templates[species].detectionRange;
+        double speciesStealth = baseStealth * parameters.templates[species].stealthLevel;
+        double speciesDetection = baseDetection * parameters.templates[species].detectionSkill;
 
         // Yeni hayvan
-        Animal* animal = new Animal(
+        env.addAnimal(
             i,
             mt() % (width - 2 * offset) + offset,
             mt() % (height - 2 * offset) + offset,
@@ -1783,13 +5275,8 @@ int main() {
             speciesDetectionRange,
             species,
             speciesStealth,
-            speciesDetection,
-            &env.animals,
-            &env.birthQueue
+            speciesDetection
         );
-
-        env.addAnimal(animal);
-        env.saveAnimalStaticData(basePath + "animal_static_data.json", animal);
     }
 
     // Ortama bitki eklenmesi
@@ -1798,33 +5285,881 @@ int main() {
             mt() % width,
             mt() % height,
             10,
-            75 + std::mt19937{ std::random_device{}() }() % 50
+            75 + mt.below(50)
         );
         env.addEntity(entity);
     }
+}
+
+/*
+    RunSettings, bir kounun dnya, poplasyon ve kt ayarlardr; tr tablolar ayrca SpeciesParameters'tadr.
+*/
+struct RunSettings {
+    int width;
+    int height;
+    int steps;
+    int offset;
+    int numAnimals;
+    int numEntities;
+    Environment::SpatialIndexType spatialIndexType;
+    double neighbourSkin;
+    Environment::OutputFormat outputFormat;
+    int outputPrecision;
+    Environment::RecordingWindow statisticsRecording;
+};
+
+/*
+    loadScenario(), bir senaryo (JSON) dosyasndan tr parametrelerini, besin zincirini, tr arlklarn, dnya
+    boyutunu, poplasyonu ve adm saysn okur. Tr tablolar parameters'a yazlr; kou bu tabloyu Environment'a
+    const referansla verir ve sonra yalnzca okur. Dosyada olmayan alanlar settings ve parameters'taki mevcut
+    deerlerinde kalr. Tr says derlemede sabittir (NUM_ANIMALS); "species" dizisi tr numaras srasndadr.
+    rnek:
+        {
+          "width": 500, "height": 500, "steps": 55000, "offset": 222,
+          "num_animals": 50, "num_plants": 50, "food_rej_per_step": 0.05,
+          "species": [
+            { "name": "Rabbit", "weight": 150,
+              "template": { "speed": 1.7, "stealth_level": 1.8, "detection_skill": 1.5, "detection_range": 1,
+                            "health_factor": 0.5, "reproduction_cooldown": 1700, "death_time": 8000, "food_capacity": 105 },
+              "limit_max": { "speed": 10 }, "limit_min": { "speed": 0 },
+              "reproduction_cooldown_random": 300, "death_time_random": 800, "max_birth_num": 1,
+              "health_decay_rate": 0, "aging_factor": 0 },
+            ...
+          ],
+          "food_chain": [ [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1], ... ]
+        }
+    Dosya okunamaz veya deerler geersizse hata yazar, hibir eyi deitirmeden false dndrr.
+*/
+bool loadScenario(const std::string& filename, RunSettings& settings, SpeciesParameters& parameters) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Dosya acma hatasi (senaryo): " << filename << std::endl;
+        return false;
+    }
+
+    json scenario = json::parse(file, nullptr, false);
+    if (scenario.is_discarded() || !scenario.is_object()) {
+        std::cerr << "Gecersiz senaryo dosyasi (JSON): " << filename << std::endl;
+        return false;
+    }
+
+    auto readTemplate = [](const json& values, AnimalTemplate& target) {
+        target.speed = values.value("speed", target.speed);
+        target.stealthLevel = values.value("stealth_level", target.stealthLevel);
+        target.detectionSkill = values.value("detection_skill", target.detectionSkill);
+        target.detectionRange = values.value("detection_range", target.detectionRange);
+        target.healthFactor = values.value("health_factor", target.healthFactor);
+        target.reproductionCooldown = values.value("reproduction_cooldown", target.reproductionCooldown);
+        target.deathTime = values.value("death_time", target.deathTime);
+        target.foodCapacity = values.value("food_capacity", target.foodCapacity);
+    };
+
+    // nce kopyalara okunur; tm dosya geerliyse settings ve parameters'a yazlr
+    RunSettings loaded = settings;
+    SpeciesParameters table = parameters;
+
+    try {
+        loaded.width = scenario.value("width", loaded.width);
+        loaded.height = scenario.value("height", loaded.height);
+        loaded.steps = scenario.value("steps", loaded.steps);
+        loaded.offset = scenario.value("offset", loaded.offset);
+        loaded.numAnimals = scenario.value("num_animals", loaded.numAnimals);
+        loaded.numEntities = scenario.value("num_plants", loaded.numEntities);
+        table.foodRejuvenation = scenario.value("food_rej_per_step", table.foodRejuvenation);
+        table.herbivoreSpeedBuff = scenario.value("buff_herbivor_speed", table.herbivoreSpeedBuff);
+
+        if (scenario.contains("species")) {
+            const json& species = scenario["species"];
+            if (!species.is_array() || species.size() != NUM_ANIMALS) {
+                std::cerr << "Gecersiz senaryo dosyasi (species " << NUM_ANIMALS << " elemanli olmali): " << filename << std::endl;
+                return false;
+            }
+            for (int i = 0; i < NUM_ANIMALS; i++) {
+                const json& entry = species[i];
+                table.names[i] = entry.value("name", table.names[i]);
+                table.speciesWeights[i] = entry.value("weight", table.speciesWeights[i]);
+                if (entry.contains("template")) readTemplate(entry["template"], table.templates[i]);
+                if (entry.contains("limit_max")) readTemplate(entry["limit_max"], table.limitMax[i]);
+                if (entry.contains("limit_min")) readTemplate(entry["limit_min"], table.limitMin[i]);
+                table.reproductionCooldownRandom[i] = entry.value("reproduction_cooldown_random", table.reproductionCooldownRandom[i]);
+                table.deathTimeRandom[i] = entry.value("death_time_random", table.deathTimeRandom[i]);
+                table.maxBirthNum[i] = entry.value("max_birth_num", table.maxBirthNum[i]);
+                table.healthDecayRate[i] = entry.value("health_decay_rate", table.healthDecayRate[i]);
+                table.agingFactor[i] = entry.value("aging_factor", table.agingFactor[i]);
+            }
+        }
+
+        if (scenario.contains("food_chain")) {
+            const json& matrix = scenario["food_chain"];
+            bool validShape = matrix.is_array() && matrix.size() == NUM_ANIMALS;
+            for (int i = 0; validShape && i < NUM_ANIMALS; i++) {
+                validShape = matrix[i].is_array() && matrix[i].size() == NUM_ANIMALS + 1;
+            }
+            if (!validShape) {
+                std::cerr << "Gecersiz senaryo dosyasi (food_chain " << NUM_ANIMALS << "x" << NUM_ANIMALS + 1 << " olmali): " << filename << std::endl;
+                return false;
+            }
+            for (int i = 0; i < NUM_ANIMALS; i++) {
+                for (int j = 0; j <= NUM_ANIMALS; j++) {
+                    table.foodChainMatrix[i][j] = matrix[i][j].get<int>() != 0 ? 1 : 0;
+                }
+            }
+        }
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Gecersiz senaryo dosyasi (" << e.what() << "): " << filename << std::endl;
+        return false;
+    }
+
+    // Rastgele ekililerde blen olarak kullanlan deerler pozitif olmal
+    int weightSum = 0;
+    bool valid = loaded.width > 2 * loaded.offset && loaded.height > 2 * loaded.offset && loaded.offset >= 0
+        && loaded.width > 0 && loaded.height > 0 && loaded.steps >= 0 && loaded.numAnimals >= 0 && loaded.numEntities >= 0;
+    for (int i = 0; i < NUM_ANIMALS; i++) {
+        valid = valid && table.speciesWeights[i] >= 0 && table.reproductionCooldownRandom[i] > 0
+            && table.deathTimeRandom[i] > 0 && table.maxBirthNum[i] > 0;
+        weightSum += table.speciesWeights[i];
+    }
+    if (!valid || weightSum <= 0) {
+        std::cerr << "Gecersiz senaryo dosyasi (deger araligi): " << filename << std::endl;
+        return false;
+    }
+
+    table.foodChainMasks = buildFoodChainMasks(table.foodChainMatrix);
+    settings = loaded;
+    parameters = table;
+    return true;
+}
+
+/*
+    runReplicate(), bir kopyay kendi tohumuyla batan sona tek i paracnda altrr. Kopya yalnzca
+    adm istatistiklerini outputPrefix + "statistics.json" dosyasna yazar; dier kayt aklar kapaldr.
+    Ayn tohum ve tr tablolaryla (parameters) tek kounun statistics.json dosyasyla ayn sonucu verir.
+*/
+void runReplicate(const RunSettings& settings, const SpeciesParameters& parameters, std::uint64_t seed,
+    const std::string& outputPrefix)
+{
+    Environment env(settings.width, settings.height, settings.spatialIndexType, parameters);
+    env.setSeed(seed);
+    env.setNeighbourSkin(settings.neighbourSkin);
+    env.setOutputPath(outputPrefix);
+    env.setOutputFormat(settings.outputFormat, settings.outputPrecision);
+    env.setRecording(Environment::AnimalTrajectoryStream, { 0, 0, -1 });
+    env.setRecording(Environment::PlantStream, { 0, 0, -1 });
+    env.setRecording(Environment::PositionHistoryStream, { 0, 0, -1 });
+    env.setRecording(Environment::AnimalStaticStream, { 0, 0, -1 });
+    env.setRecording(Environment::StatisticsStream, settings.statisticsRecording);
+
+    env.clearFile(outputPrefix + "statistics.json");
+    populateEnvironment(env, settings.width, settings.height, settings.numAnimals, settings.numEntities, settings.offset);
+
+    for (int i = 0; i < settings.steps; i++) {
+        env.update(i);
+    }
+
+    env.finalizeExport(outputPrefix + "statistics.json");
+    env.output.flush();
+}
+
+// EnsembleScenario, parametre taramasnn bir noktasdr: bir senaryo dosyasndan yklenen ayarlar ve tr tablolar.
+struct EnsembleScenario {
+    RunSettings settings;
+    SpeciesParameters parameters;
+};
+
+/*
+    runEnsemble(), her senaryonun replicates adet bamsz kopyasn threads i paracnda ezamanl altrr.
+    Her i parac sradaki (senaryo, kopya) iini alr; kopya yalnzca kendi senaryosunun tablolarn okur
+    (kopyalar arasnda paylalan deiken durum yoktur).
+    Kopya r'nin tohumu her senaryoda baseSeed + r'dir (senaryolar ayn tohumlarla karlatrlr). kts
+    basePath + "replicate_<r>_statistics.json", birden fazla senaryoda "scenario_<s>_replicate_<r>_statistics.json"dr.
+    Olay gnl (logEvents) kou boyunca kapatlr: kopyalar ayn cout'a ezamanl yazmasn.
+*/
+void runEnsemble(const std::vector<EnsembleScenario>& scenarios, int replicates, int threads, std::uint64_t baseSeed) {
+    int runs = static_cast<int>(scenarios.size()) * replicates;
+    threads = std::max(1, std::min(threads, runs));
+    std::atomic<int> nextRun(0);
+
+    bool previousLogEvents = logEvents;
+    logEvents = false;
+
+    auto worker = [&]() {
+        for (int run = nextRun++; run < runs; run = nextRun++) {
+            int scenario = run / replicates;
+            int r = run % replicates;
+            std::string prefix = basePath;
+            if (scenarios.size() > 1) {
+                prefix += "scenario_" + std::to_string(scenario) + "_";
+            }
+            prefix += "replicate_" + std::to_string(r) + "_";
+            runReplicate(scenarios[scenario].settings, scenarios[scenario].parameters, baseSeed + r, prefix);
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    logEvents = previousLogEvents;
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    cout << "Topluluk: " << scenarios.size() << " senaryo x " << replicates << " kopya, " << threads << " is parcacigi, "
+        << duration.count() << " saniye (" << runs / duration.count() << " kopya/saniye).\n";
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+/*
+    Mikro kyaslamalar (microbenchmark): uzaysal indeksleri ve alglama ekirdeklerini tam simlasyondan bamsz ler.
+    Yapay poplasyonlar sabit tohumla retilir, bylece indeks deiiklikleri ayn girdiyle karlatrlabilir:
+     - uniform: konumlar dnyaya dzgn dalr
+     - clustered: 20 kme merkezi etrafnda normal dalm (sigma: dnya boyunun %3')
+     - herd: 25 hayvanlk srler; yeler sr merkezinin 5 birim evresinde
+*/
+enum BenchmarkDistribution {
+    UniformDistribution,
+    ClusteredDistribution,
+    HerdDistribution,
+    NUM_BENCHMARK_DISTRIBUTIONS
+};
+
+const char* benchmarkDistributionNames[NUM_BENCHMARK_DISTRIBUTIONS] = { "uniform", "clustered", "herd" };
+
+/*
+    fillBenchmarkPopulation(), depoya count hayvan ekler (worldSize x worldSize alannda, hepsinin menzili detectionRange).
+*/
+void fillBenchmarkPopulation(AnimalStore& store, BenchmarkDistribution distribution, int count, double worldSize,
+    double detectionRange, std::uint64_t seed)
+{
+    std::uint32_t draws = 0;
+    CounterRng random{ seed, 0, RNG_SETUP_DOMAIN, 0, draws };
+    std::normal_distribution<double> clusterOffset(0.0, worldSize * 0.03);
+    std::normal_distribution<double> herdOffset(0.0, 5.0);
+
+    std::vector<std::pair<double, double>> centers;
+    int centerCount = (distribution == ClusteredDistribution) ? 20 : (count + 24) / 25;
+    for (int c = 0; c < centerCount; c++) {
+        centers.emplace_back(random.uniform() * worldSize, random.uniform() * worldSize);
+    }
+
+    store.clear();
+    store.seed = seed;
+    store.reserve(count);
+    for (int i = 0; i < count; i++) {
+        double x, y;
+        if (distribution == UniformDistribution) {
+            x = random.uniform() * worldSize;
+            y = random.uniform() * worldSize;
+        }
+        else {
+            const auto& center = (distribution == ClusteredDistribution) ? centers[random.below(centerCount)] : centers[i / 25];
+            std::normal_distribution<double>& offset = (distribution == ClusteredDistribution) ? clusterOffset : herdOffset;
+            x = fmod(center.first + offset(random) + worldSize, worldSize);
+            y = fmod(center.second + offset(random) + worldSize, worldSize);
+        }
+        store.add(i, x, y, 1.0, detectionRange, i % 2, random.uniform() * 0.5, random.uniform() * 0.5);
+    }
+}
+
+// bestOf(), body'yi repeats kez altrr ve en ksa sreyi (saniye) dndrr.
+template <typename Body>
+double bestOf(int repeats, Body&& body) {
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repeats; r++) {
+        auto start = std::chrono::steady_clock::now();
+        body(r);
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        best = std::min(best, duration.count());
+    }
+    return best;
+}
+
+/*
+    runMicrobenchmarks(), her dalm, poplasyon (younluk) ve alglama menzili iin unlar ler (ns, en iyi tekrar):
+     - insert: indeksin tm hayvanlarla yeniden kurulmas (hayvan bana)
+     - update: her hayvan 1 birim kaydktan sonra indeksin gncellenmesi (hayvan bana; artml aata yalnzca tananlar)
+     - query / entity: retrieveAnimal / retrieveEntity (sorgu bana); komsu: sorgu bana ortalama aday
+     - tur: sorgulayann ilgilendii trlerle (parameters->foodChainMasks.relevant) szlen retrieveAnimal (sorgu bana)
+     - detect: Animal::detectAnimals (ar bana ve aday bana), plant: PlantIndex::retrievePlants (sorgu bana)
+     - lineCircleIntersection (ar bana)
+     - hareket aamas: moveAnimalsBatch ve karlatrma iin cos/sin + fmod ile hayvan bana dng (hayvan bana)
+*/
+void runMicrobenchmarks(std::ostream& out) {
+    const double worldSize = 2000;
+    const int counts[] = { 1000, 10000, 100000 };
+    const double ranges[] = { 20, 40, 80 };
+    const int QUERY_SAMPLE = 10000;         // Sorgu lmlerinde kullanlan en fazla hayvan
+    const int DETECT_SAMPLE = 2000;         // Alglama lmnde kullanlan en fazla hayvan
+    const int REPEATS = 3;
+    const std::uint64_t seed = 20250101;
+
+    const char* indexNames[] = { "QuadTree", "IncrementalQuadTree", "UniformGrid" };
+    double sink = 0;        // llen arlarn sonular; derleyicinin onlar atmasn nler
+
+    out << std::fixed << std::setprecision(1);
+    out << "Mikro kiyaslama (ns, " << REPEATS << " tekrarin en iyisi, dunya " << worldSize << "x" << worldSize << ")\n";
+    out << std::left << std::setw(21) << "indeks" << std::setw(11) << "dagilim" << std::right << std::setw(8) << "N"
+        << std::setw(8) << "menzil" << std::setw(11) << "insert" << std::setw(11) << "update" << std::setw(11) << "query"
+        << std::setw(9) << "komsu" << std::setw(11) << "tur" << std::setw(11) << "entity" << std::setw(11) << "detect" << std::setw(12) << "detect/aday"
+        << std::setw(11) << "plant" << "\n";
+
+    for (int d = 0; d < NUM_BENCHMARK_DISTRIBUTIONS; d++) {
+        for (int count : counts) {
+            for (double range : ranges) {
+                AnimalStore store;
+                fillBenchmarkPopulation(store, static_cast<BenchmarkDistribution>(d), count, worldSize, range, seed);
+
+                // Bitkiler: hayvan saysnn onda biri, dzgn dalml (retrieveEntity iin Entity olarak da eklenir)
+                std::uint32_t plantDraws = 0;
+                CounterRng plantRandom{ seed, 1, RNG_SETUP_DOMAIN, 0, plantDraws };
+                std::vector<std::unique_ptr<Plant>> plantPool;
+                std::vector<Entity*> entities;
+                PlantIndex plantIndex(worldSize, worldSize, 40.0);
+                for (int i = 0; i < count / 10; i++) {
+                    plantPool.emplace_back(new Plant(plantRandom.uniform() * worldSize, plantRandom.uniform() * worldSize, 10, 100));
+                    entities.push_back(plantPool.back().get());
+                    plantIndex.addPlant(plantPool.back().get());
+                }
+                plantIndex.prepare();
+
+                std::vector<int> sample;
+                int queryStride = std::max(1, count / QUERY_SAMPLE);
+                for (int i = 0; i < count; i += queryStride) {
+                    sample.push_back(i);
+                }
+
+                std::vector<int> result;
+                std::vector<Entity*> entityResult;
+                std::vector<Plant*> plantResult;
+                std::vector<double> baseX = store.x, baseY = store.y;
+                double neighbours = 0;
+
+                for (int type = 0; type < 3; type++) {
+                    SpatialIndex* index = (type == 2)
+                        ? static_cast<SpatialIndex*>(new UniformGrid(worldSize, worldSize, 40.0, &store))
+                        : static_cast<SpatialIndex*>(new QuadTree(0, 0, 0, worldSize, worldSize, &store, type == 1));
+                    std::vector<Entity*> noEntities;
+
+                    double insertTime = bestOf(REPEATS, [&](int) {
+                        index->rebuild(count, noEntities);
+                    });
+
+                    // Konum kaydrma sresi lme katlmaz; yalnzca update() llr
+                    double updateTime = std::numeric_limits<double>::max();
+                    for (int repeat = 0; repeat < REPEATS; repeat++) {
+                        double shift = (repeat % 2 == 0) ? 1.0 : -1.0;
+                        for (int i = 0; i < count; i++) {
+                            store.x[i] = fmod(store.x[i] + shift + worldSize, worldSize);
+                        }
+                        auto start = std::chrono::steady_clock::now();
+                        index->update(count, noEntities);
+                        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+                        updateTime = std::min(updateTime, duration.count());
+                    }
+                    store.x = baseX;
+                    store.y = baseY;
+                    index->rebuild(count, noEntities);
+
+                    double queryTime = bestOf(REPEATS, [&](int) {
+                        neighbours = 0;
+                        for (int i : sample) {
+                            result.clear();
+                            index->retrieveAnimal(i, store.x[i], store.y[i], range, result);
+                            neighbours += result.size();
+                        }
+                    });
+
+                    double filteredTime = bestOf(REPEATS, [&](int) {
+                        for (int i : sample) {
+                            result.clear();
+                            index->retrieveAnimal(i, store.x[i], store.y[i], range, store.parameters->foodChainMasks.relevant[store.species[i]], result);
+                            sink += result.size();
+                        }
+                    });
+
+                    index->rebuild(count, entities);
+                    double entityTime = bestOf(REPEATS, [&](int) {
+                        for (int i : sample) {
+                            entityResult.clear();
+                            index->retrieveEntity(store.x[i], store.y[i], range, entityResult);
+                            sink += entityResult.size();
+                        }
+                    });
+
+                    // Alglama ve bitki sorgusu indeksten bamszdr; yalnzca ilk indeksle llr
+                    double detectTime = 0, detectCandidates = 0, plantTime = 0;
+                    if (type == 0) {
+                        std::vector<std::vector<int>> candidates;
+                        int detectStride = std::max(1, count / DETECT_SAMPLE);
+                        for (int i = 0; i < count; i += detectStride) {
+                            candidates.emplace_back();
+                            index->retrieveAnimal(i, store.x[i], store.y[i], range, candidates.back());
+                            detectCandidates += candidates.back().size();
+                        }
+                        detectTime = bestOf(REPEATS, [&](int) {
+                            store.beginStep(0);
+                            for (size_t k = 0; k < candidates.size(); k++) {
+                                Animal animal(&store, static_cast<int>(k) * detectStride);
+                                animal.detectAnimals(candidates[k]);
+                                sink += store.detectedAnimals[k * detectStride].size();
+                            }
+                        }) / candidates.size();
+                        detectCandidates /= candidates.size();
+
+                        plantTime = bestOf(REPEATS, [&](int) {
+                            for (int i : sample) {
+                                plantResult.clear();
+                                plantIndex.retrievePlants(store.x[i], store.y[i], range, plantResult);
+                                sink += plantResult.size();
+                            }
+                        }) / sample.size();
+                    }
+
+                    out << std::left << std::setw(21) << indexNames[type] << std::setw(11) << benchmarkDistributionNames[d]
+                        << std::right << std::setw(8) << count << std::setw(8) << range
+                        << std::setw(11) << insertTime / count * 1e9
+                        << std::setw(11) << updateTime / count * 1e9
+                        << std::setw(11) << queryTime / sample.size() * 1e9
+                        << std::setw(9) << neighbours / sample.size()
+                        << std::setw(11) << filteredTime / sample.size() * 1e9
+                        << std::setw(11) << entityTime / sample.size() * 1e9;
+                    if (type == 0) {
+                        out << std::setw(11) << detectTime * 1e9
+                            << std::setw(12) << (detectCandidates > 0 ? detectTime / detectCandidates * 1e9 : 0.0)
+                            << std::setw(11) << plantTime * 1e9;
+                    }
+                    out << "\n";
+                    delete index;
+                }
+            }
+        }
+    }
+
+    // lineCircleIntersection: rastgele doru paralar ve daireler
+    const int SEGMENTS = 1000000;
+    std::uint32_t segmentDraws = 0;
+    CounterRng segmentRandom{ seed, 2, RNG_SETUP_DOMAIN, 0, segmentDraws };
+    std::vector<double> segments(SEGMENTS * 7);
+    for (double& value : segments) {
+        value = segmentRandom.uniform() * 100;
+    }
+    double intersectionTime = bestOf(REPEATS, [&](int) {
+        int hits = 0;
+        for (int i = 0; i < SEGMENTS; i++) {
+            const double* v = &segments[i * 7];
+            hits += lineCircleIntersection(v[0], v[1], v[2], v[3], v[4], v[5], v[6] * 0.2);
+        }
+        sink += hits;
+    });
+    out << "lineCircleIntersection: " << intersectionTime / SEGMENTS * 1e9 << " ns/cagri\n";
+
+    // Hareket aamas: 100k hayvan, rastgele yn ve mesafe
+    const int MOVERS = 100000;
+    std::vector<double> moveX(MOVERS), moveY(MOVERS), moveAngle(MOVERS), moveSpeed(MOVERS), moveDistance(MOVERS);
+    for (int i = 0; i < MOVERS; i++) {
+        moveX[i] = segmentRandom.uniform() * worldSize;
+        moveY[i] = segmentRandom.uniform() * worldSize;
+        moveAngle[i] = segmentRandom.uniform() * 2 * PI;
+        moveSpeed[i] = segmentRandom.uniform() * 3;
+    }
+    double batchMoveTime = bestOf(REPEATS, [&](int) {
+        std::copy(moveSpeed.begin(), moveSpeed.end(), moveDistance.begin());
+        moveAnimalsBatch(moveX.data(), moveY.data(), moveAngle.data(), moveDistance.data(), MOVERS, worldSize, worldSize);
+    });
+    double referenceMoveTime = bestOf(REPEATS, [&](int) {
+        for (int i = 0; i < MOVERS; i++) {
+            moveX[i] = fmod(moveX[i] + cos(moveAngle[i]) * moveSpeed[i] + worldSize, worldSize);
+            moveY[i] = fmod(moveY[i] + sin(moveAngle[i]) * moveSpeed[i] + worldSize, worldSize);
+        }
+    });
+    sink += moveX[0] + moveY[MOVERS - 1];
+    out << "moveAnimalsBatch: " << batchMoveTime / MOVERS * 1e9 << " ns/hayvan (cos/sin + fmod: "
+        << referenceMoveTime / MOVERS * 1e9 << " ns/hayvan)\n";
+    out << "(kontrol toplami: " << sink << ")\n";
+    out.unsetf(std::ios_base::floatfield);
+}
+
+/*
+    peakMemoryMB(), srecin imdiye kadarki en yksek bellek kullanmn (peak RSS / peak working set, MB) dndrr.
+*/
+double peakMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss / 1024.0;       // Linux'ta kilobayt
+    }
+    return 0;
+#endif
+}
+
+/*
+    ScalingCase, leklenme kyaslamasndaki bir koudur: balang poplasyonu, bitki says,
+    kare dnyann kenar ve i parac says.
+*/
+struct ScalingCase {
+    int animals;
+    int plants;
+    int worldSize;
+    int threads;
+};
+
+/*
+    runScalingBenchmark(), Environment::update()'in poplasyon, bitki says, dnya boyutu ve i parac saysyla
+    nasl leklendiini ler. Tm kayt aklar ve olay mesajlar kapaldr. Her kou birka snma admndan sonra
+    yaklak sabit sayda hayvan gncellemesi yapacak kadar adm atar; sonular CSV olarak reportFile'a yazlr
+    (her koudan sonra, yarda kesilse bile o ana kadarki sonular kalr):
+        animals, plants, world, threads, steps, steps_per_sec, agent_updates_per_sec, ns_per_agent_update,
+        final_animals, peak_rss_mb
+    Hayvan gncellemesi bana sre (ns_per_agent_update) poplasyonla artyorsa admda dorusal olmayan bir ilem vardr.
+    peak_rss_mb srecin o ana kadarki tepe deeridir; koular kkten bye sral olduu iin son kouyu yanstr.
+    Koular verilen senaryonun tr tablolaryla (parameters) ve settings'teki uzaysal indeks ve komu listesi payyla
+    (neighbourSkin > 0 ise Verlet listeleri, bkz. Environment::setNeighbourSkin) yaplr.
+     parac karlatrmas 1 i paracn taban alr; adm kurallar i parac saysndan bamsz olduu iin
+    satrlar ayn dinamii ler.
+*/
+void runScalingBenchmark(const std::string& reportFile, const RunSettings& settings, const SpeciesParameters& parameters) {
+    std::vector<ScalingCase> cases;
+    int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts = { 1 };
+    if (hardwareThreads > 1) {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    // Sabit younluk (senaryonun hayvan ve bitki younluu; varsaylan: 500x500'de 50 hayvan ve 50 bitki):
+    // poplasyon ve dnya birlikte byr
+    double areaPerAnimal = static_cast<double>(settings.width) * settings.height / std::max(settings.numAnimals, 1);
+    double plantsPerAnimal = static_cast<double>(settings.numEntities) / std::max(settings.numAnimals, 1);
+    for (int animals : { 1000, 10000, 100000, 1000000 }) {
+        int worldSize = static_cast<int>(std::sqrt(animals * areaPerAnimal));
+        int plants = static_cast<int>(animals * plantsPerAnimal);
+        for (int threads : threadCounts) {
+            cases.push_back({ animals, plants, worldSize, threads });
+        }
+    }
+    // Sabit dnya (2000x2000): younluk ve bitki oran deiir
+    for (int animals : { 1000, 10000, 100000 }) {
+        for (int plants : { animals / 10, animals }) {
+            for (int threads : threadCounts) {
+                cases.push_back({ animals, plants, 2000, threads });
+            }
+        }
+    }
+    std::stable_sort(cases.begin(), cases.end(), [](const ScalingCase& a, const ScalingCase& b) {
+        return a.animals < b.animals;
+    });
+
+    std::ofstream report(reportFile);
+    if (!report.is_open()) {
+        std::cerr << "Dosya acma hatasi (kiyaslama raporu): " << reportFile << std::endl;
+        return;
+    }
+    report << "animals,plants,world,threads,steps,steps_per_sec,agent_updates_per_sec,ns_per_agent_update,final_animals,peak_rss_mb\n";
+
+    const int WARMUP_STEPS = 2;
+    const double AGENT_UPDATE_BUDGET = 2e6;    // Kou bana hedeflenen hayvan gncellemesi
+
+    bool previousLogEvents = logEvents;
+    logEvents = false;
+
+    for (const ScalingCase& c : cases) {
+        Environment env(c.worldSize, c.worldSize, settings.spatialIndexType, parameters);
+        env.setSeed(rngSeed);
+        env.setThreadCount(c.threads);
+        env.setNeighbourSkin(settings.neighbourSkin);
+        for (int stream = 0; stream < Environment::NUM_RECORDING_STREAMS; stream++) {
+            env.setRecording(static_cast<Environment::RecordingStream>(stream), { 0, 0, -1 });
+        }
+        populateEnvironment(env, c.worldSize, c.worldSize, c.animals, c.plants, 0);
+
+        int steps = std::clamp(static_cast<int>(AGENT_UPDATE_BUDGET / c.animals), 5, 200);
+        int step = 0;
+        for (; step < WARMUP_STEPS; step++) {
+            env.update(step);
+        }
+
+        double agentUpdates = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++, step++) {
+            agentUpdates += env.animals.size();
+            env.update(step);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        report << c.animals << "," << c.plants << "," << c.worldSize << "," << c.threads << "," << steps << ","
+            << steps / seconds << "," << agentUpdates / seconds << "," << (agentUpdates > 0 ? seconds / agentUpdates * 1e9 : 0) << ","
+            << env.animals.size() << "," << peakMemoryMB() << "\n";
+        report.flush();
+
+        cout << "Olcek: " << c.animals << " hayvan, " << c.plants << " bitki, " << c.worldSize << "x" << c.worldSize
+            << ", " << c.threads << " is parcacigi -> " << steps / seconds << " adim/s, "
+            << agentUpdates / seconds << " hayvan guncellemesi/s\n";
+    }
+
+    logEvents = previousLogEvents;
+}
+
+// parseCount(), komut satrndaki negatif olmayan bir tam sayy okur; say deilse veya aralk dndaysa false dner.
+bool parseCount(const char* text, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || parsed < 0 || parsed > INT_MAX) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// parseSeed(), komut satrndaki 64 bitlik tohumu okur (iaretsiz ondalk say).
+bool parseSeed(const char* text, std::uint64_t& value) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || text[0] == '-') {
+        return false;
+    }
+    value = static_cast<std::uint64_t>(parsed);
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    //ios_base::sync_with_stdio(false);
+
+    int width = 500;
+    int height = 500;
+    int steps = 55000;
+    int offset = 222;
+
+    // Komu sorgular iin uzaysal indeks: QuadTreeIndex, IncrementalQuadTreeIndex veya UniformGridIndex
+    Environment::SpatialIndexType spatialIndexType = Environment::QuadTreeIndex;
+
+    // Paralel adm iin i parac says (0: tek i parackl adm)
+    int threadCount = 0;
+
+    // Verlet komu listelerinin pay (skin): > 0 ise her hayvann komular detection_range + neighbourSkin
+    // yarapyla listelenir ve hayvan neighbourSkin/2'den fazla yer deitirene kadar yeniden kullanlr (0: kapal).
+    double neighbourSkin = 0;
+
+    // Kounun kk tohumu; ayn tohum ve ayarlarla simlasyon aynen tekrarlanr (0: rastgele bir tohum kullan).
+    // Komut satrnda --seed ile verilebilir.
+    std::uint64_t seed = 0;
+
+    // JSON kt biimi (JsonArrayOutput veya NdjsonOutput) ve ondalk basamak says (-1: tam hassasiyet)
+    Environment::OutputFormat outputFormat = Environment::JsonArrayOutput;
+    int outputPrecision = -1;
+
+    // Bitki verisi: her plantKeyframeInterval admda tam kayt, arada food deeri plantFoodTolerance'tan fazla deienler
+    int plantKeyframeInterval = 100;
+    double plantFoodTolerance = 0.0;
+
+    // Kayt pencereleri {interval, start, stop}: start admndan itibaren her interval admda bir, stop admna kadar
+    // (stop = -1: sona kadar). rnein { 100, 5000, -1 }: snmadan sonra her 100. adm.
+    Environment::RecordingWindow trajectoryRecording = { 1, 0, -1 };
+    Environment::RecordingWindow plantRecording = { 1, 0, -1 };
+    Environment::RecordingWindow positionRecording = { 1, 0, -1 };
+    Environment::RecordingWindow statisticsRecording = { 1, 0, -1 };
+
+    int numAnimals = 50;
+    int numEntities = 50;
+
+    /*
+        Komut satr: abm [--seed N] [--replicates N] [--ensemble-threads N] [--microbench]
+                          [--scaling-benchmark rapor.csv] [senaryo.json ...]
+         - senaryo.json: tr parametreleri, besin zinciri, tr arlklar, dnya boyutu, poplasyon ve adm says
+           bu JSON dosyasndan okunur (bkz. loadScenario); verilmezse derlemedeki varsaylanlar kullanlr.
+         - --seed N: kounun kk tohumu (rngSeed); bir kou, kopya veya tarama noktas bu tohumla yeniden retilir.
+         - --replicates N: N > 0 ise tek kou yerine her senaryonun N bamsz kopyas ezamanl alr (topluluk).
+           Kopya r'nin tohumu rngSeed + r'dir ve yalnzca istatistiklerini yazar (bkz. runEnsemble).
+         - --ensemble-threads N: topluluk kousunun i parac says (varsaylan: ekirdek says).
+         - --microbench: simlasyon yerine uzaysal indeks ve alglama ekirdeklerinin mikro kyaslamalar alr.
+         - --scaling-benchmark rapor.csv: simlasyon yerine poplasyon, dnya boyutu ve i parac taramas yaplr
+           (ilk senaryonun tablolar ve younluuyla); sonular rapor.csv'ye yazlr (bkz. runScalingBenchmark).
+        Birden fazla senaryo dosyas bir parametre taramasdr ve topluluk olarak alr (--replicates yoksa 1 kopya).
+        Bylece kopya ve tarama koular yeniden derleme gerektirmez.
+    */
+    int replicates = 0;
+    int ensembleThreads = static_cast<int>(std::thread::hardware_concurrency());
+    bool runMicrobenchmarksOnly = false;
+    std::string scalingReport;
+    std::vector<std::string> scenarioFiles;
+    for (int arg = 1; arg < argc; arg++) {
+        std::string option = argv[arg];
+        if (option == "--replicates" || option == "--ensemble-threads") {
+            int value = 0;
+            if (arg + 1 >= argc || !parseCount(argv[++arg], value)) {
+                std::cerr << "Gecersiz arguman: " << option << " negatif olmayan bir tam sayi bekler" << std::endl;
+                return 1;
+            }
+            (option == "--replicates" ? replicates : ensembleThreads) = value;
+        }
+        else if (option == "--seed") {
+            if (arg + 1 >= argc || !parseSeed(argv[++arg], seed)) {
+                std::cerr << "Gecersiz arguman: --seed negatif olmayan bir 64 bit tam sayi bekler" << std::endl;
+                return 1;
+            }
+        }
+        else if (option == "--microbench") {
+            runMicrobenchmarksOnly = true;
+        }
+        else if (option == "--scaling-benchmark") {
+            if (arg + 1 >= argc) {
+                std::cerr << "Gecersiz arguman: --scaling-benchmark bir rapor dosyasi bekler" << std::endl;
+                return 1;
+            }
+            scalingReport = argv[++arg];
+        }
+        else if (option.compare(0, 2, "--") == 0) {
+            std::cerr << "Bilinmeyen arguman: " << option << std::endl;
+            return 1;
+        }
+        else {
+            scenarioFiles.push_back(option);
+        }
+    }
+
+    if (seed != 0) {
+        rngSeed = seed;
+    }
+    cout << "Tohum (rngSeed): " << rngSeed << "\n";
+
+    // Mikro kyaslama (--microbench): simlasyon yerine uzaysal indeks ve alglama ekirdekleri llr
+    if (runMicrobenchmarksOnly) {
+        runMicrobenchmarks(cout);
+        return 0;
+    }
+
+    RunSettings defaultSettings = { width, height, steps, offset, numAnimals, numEntities,
+        spatialIndexType, neighbourSkin, outputFormat, outputPrecision, statisticsRecording };
+    std::vector<EnsembleScenario> scenarios;
+    if (scenarioFiles.empty()) {
+        scenarios.push_back({ defaultSettings, defaultSpeciesParameters });
+    }
+    for (const std::string& scenarioFile : scenarioFiles) {
+        EnsembleScenario scenario = { defaultSettings, defaultSpeciesParameters };
+        if (!loadScenario(scenarioFile, scenario.settings, scenario.parameters)) {
+            return 1;
+        }
+        cout << "Senaryo yuklendi: " << scenarioFile << "\n";
+        scenarios.push_back(scenario);
+    }
+
+    // leklenme kyaslamas (--scaling-benchmark): simlasyon yerine poplasyon, dnya boyutu ve i parac
+    // taramas yaplr; sonular scalingReport dosyasna CSV olarak yazlr (kayt aklar kapaldr).
+    if (!scalingReport.empty()) {
+        runScalingBenchmark(scalingReport, scenarios[0].settings, scenarios[0].parameters);
+        return 0;
+    }
+
+    if (scenarios.size() > 1 && replicates == 0) {
+        replicates = 1;
+    }
+    if (replicates > 0) {
+        runEnsemble(scenarios, replicates, ensembleThreads, rngSeed);
+        return 0;
+    }
+
+    const RunSettings& settings = scenarios[0].settings;
+    const SpeciesParameters& parameters = scenarios[0].parameters;
+
+    // Checkpoint: resumeFrom bo deilse balang poplasyonu kurulmaz, simlasyon bu dosyadan devam eder.
+    // checkpointInterval > 0 ise her checkpointInterval admda bir checkpointPath dosyasna kayt alnr.
+    std::string resumeFrom = "";
+    std::string checkpointPath = basePath + "checkpoint.bin";
+    int checkpointInterval = 0;
+
+    // Adm profili: profileSteps aksa update() evrelerinin sreleri llr ve kou sonunda p50/p95/p99/max
+    // olarak yazdrlr; profileCsv bo deilse her admn evre sreleri bu dosyaya da yazlr.
+    bool profileSteps = false;
+    std::string profileCsv = "";
+
+    Environment env(settings.width, settings.height, spatialIndexType, parameters);
+    env.setSeed(rngSeed);
+    env.setThreadCount(threadCount);
+    env.setNeighbourSkin(neighbourSkin);
+    env.setOutputFormat(outputFormat, outputPrecision);
+    env.setPlantOutput(plantKeyframeInterval, plantFoodTolerance);
+    env.setRecording(Environment::AnimalTrajectoryStream, trajectoryRecording);
+    env.setRecording(Environment::PlantStream, plantRecording);
+    env.setRecording(Environment::PositionHistoryStream, positionRecording);
+    env.setRecording(Environment::StatisticsStream, statisticsRecording);
+    env.profiler.setEnabled(profileSteps);
+    if (profileSteps && !profileCsv.empty()) {
+        env.profiler.openCsv(env.output, profileCsv);
+    }
+
+    // Verilerin kaydedilecei JSON dosyalarn temizle (balang ayarlar).
+    env.clearFile(basePath + "plant_static_data.json");
+    env.clearFile(basePath + "plant_data1.json");
+    env.clearFile(basePath + "quadtree_data1.json");
+    env.clearFile(basePath + "animal_static_data.json");
+    env.clearFile(basePath + "statistics.json");
+    env.trajectory.open(env.output, basePath + "animal_dynamic_data.bin");
+
+    int startStep = 0;
+    if (!resumeFrom.empty()) {
+        if (!env.loadCheckpoint(resumeFrom, startStep)) {
+            return 1;
+        }
+        cout << "Checkpoint yuklendi: " << resumeFrom << " (adim: " << startStep << ", tohum: " << env.getSeed() << ")\n";
+    }
+    else {
+        populateEnvironment(env, settings.width, settings.height, settings.numAnimals, settings.numEntities, settings.offset);
+    }
+
+    // Sabit veriler: yeni doanlar update() iinde, balangtaki (veya checkpoint'ten yklenen) hayvanlar burada yazlr
+    for (int animal = 0; animal < static_cast<int>(env.animals.size()); animal++) {
+        env.saveAnimalStaticData(basePath + "animal_static_data.json", animal);
+    }
+    env.savePlantStaticData(basePath + "plant_static_data.json");
 
     // Tm simlasyonun zaman lm
     auto totalStart = std::chrono::high_resolution_clock::now();
 
-    for (int i = 0; i < steps; i++) {
+    for (int i = startStep; i < settings.steps; i++) {
         auto stepStart = std::chrono::high_resolution_clock::now();
         env.update(i);
         auto stepEnd = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> stepDuration = stepEnd - stepStart;
         //cout << "Adim " << i+1 << " suresi: " << stepDuration.count() << " saniye.\n";
+
+        if (checkpointInterval > 0 && (i + 1) % checkpointInterval == 0) {
+            env.saveCheckpoint(checkpointPath, i + 1);
+        }
     }
 
     auto totalEnd = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> totalDuration = totalEnd - totalStart;
 
     cout << "Toplam calisma suresi: " << totalDuration.count() << " saniye.\n";
-    cout << "Adim basina sure: " << totalDuration.count() / steps << " saniye.\n";
+    cout << "Adim basina sure: " << totalDuration.count() / std::max(settings.steps - startStep, 1) << " saniye.\n";
+    env.profiler.report(cout);
+    env.profiler.closeCsv();
 
-    // JSON dosyalar iin dizileri kapat
+    // JSON dosyalarn kapat (dizi biiminde "]" yazlr)
+    env.finalizeExport(basePath + "plant_static_data.json");
     env.finalizeExport(basePath + "plant_data1.json");
     env.finalizeExport(basePath + "quadtree_data1.json");
     env.finalizeExport(basePath + "animal_static_data.json");
-    env.finalizeExport(basePath + "animal_dynamic_data.json");
+    env.finalizeExport(basePath + "statistics.json");
+
+    // Trajectory dosyasnn adm indeksini yaz ve kapat
+    env.trajectory.close();
+
+    // Python betii dosyalar okumadan nce kuyruktaki tm yazmalarn bitmesini bekle
+    env.output.flush();
 
     // stee bal: Python scripti altr
     std::string pythonCommand = "py C:\\Users\\Doruk\\env\\tubitak2025\\simulation.py";
@@ -5,6 +5,7 @@ import os
 import json
 from matplotlib.patches import Rectangle
 from matplotlib.animation import FFMpegWriter
+from trajectory import read_trajectory
 
 num = 19;
 str_num = str(num);
@@ -14,19 +15,23 @@ path_prefix = 'C:\\Users\\keles\\env\\tubitak2025\\json\\' + str_num + '\\'
 # Gerçek ffmpeg yolunuzu güncelleyin
 os.environ['PATH'] += r";C:\Users\keles\Masaüstü\ffmpeg-2024-10-07-git-496b8d7a13-full_build\ffmpeg-2024-10-07-git-496b8d7a13-full_build\bin"
 
+# JSON dizisi ya da satır başına bir nesne (NDJSON) biçimindeki dosyayı okur
 def read_json_file(filename):
     with open(filename, 'r') as f:
-        return json.load(f)
+        text = f.read()
+    if text.lstrip().startswith('['):
+        return json.loads(text)
+    return [json.loads(line) for line in text.splitlines() if line.strip()]
 
 # Dosya yolları
 static_animal_filename = path_prefix + 'animal_static_data.json'
-dynamic_animal_filename = path_prefix + 'animal_dynamic_data.json'
+dynamic_animal_filename = path_prefix + 'animal_dynamic_data.bin'
+plant_static_filename = path_prefix + 'plant_static_data.json'
 plant_filename = path_prefix + 'plant_data1.json'
 
 # Önce statik hayvan verilerini yükle
 def load_static_animal_data(static_filename):
-    with open(static_filename, 'r') as f:
-        static_data = json.load(f)
+    static_data = read_json_file(static_filename)
     # Hayvan kimliklerini statik özellikleriyle eşleştirmek için bir sözlük oluştur
     static_animal_info = {}
     for animal in static_data:
@@ -38,8 +43,18 @@ def load_static_animal_data(static_filename):
 
 # Verileri yükle
 static_animal_info = load_static_animal_data(static_animal_filename)
-dynamic_animal_data = read_json_file(dynamic_animal_filename)
-plant_data = read_json_file(plant_filename)
+dynamic_animal_data = list(read_trajectory(dynamic_animal_filename))
+
+# Bitki konumları sabittir; adım kayıtları yalnızca food değeri değişen bitkileri içerir (anahtar karelerde hepsini).
+# Her karedeki food değerleri önceki karelerden devralınarak kurulur.
+plant_static_data = read_json_file(plant_static_filename)
+x_plants = [plant['x'] for plant in plant_static_data]
+y_plants = [plant['y'] for plant in plant_static_data]
+plant_data = []
+plant_food = np.zeros(len(plant_static_data))
+for step_data in read_json_file(plant_filename):
+    plant_food[step_data['id']] = step_data['food']
+    plant_data.append(plant_food.copy())
 
 # Grafiği hazırla
 fig, ax = plt.subplots(figsize=(10, 10))
@@ -55,30 +70,28 @@ plant_scatter = ax.scatter([], [], s=10, alpha=0.6, color='green')
 def update(frame):
     x_animals, y_animals = [], []
     facecolors_animals, edgecolors_animals, sizes_animals = [], [], []
-    x_plants, y_plants, sizes_plants = [], [], []
+    sizes_plants = []
 
     # Hayvanları işle
-    if frame < len(dynamic_animal_data) and 'data' in dynamic_animal_data[frame]:
-        for animal in dynamic_animal_data[frame]['data']:
+    if frame < len(dynamic_animal_data):
+        step_data = dynamic_animal_data[frame]
+        for animal_id, x, y, health in zip(step_data['id'].tolist(), step_data['x'], step_data['y'], step_data['health']):
             # Bu hayvan için statik bilgiyi al
-            static_info = static_animal_info.get(animal['id'], {})
+            static_info = static_animal_info.get(animal_id, {})
             
-            x_animals.append(animal['x'])
-            y_animals.append(animal['y'])
+            x_animals.append(x)
+            y_animals.append(y)
             
             # Statik veriye göre otçul durumuna bağlı renk
             facecolors_animals.append('green' if static_info.get('is_herbivore', False) else 'red')
             edgecolors_animals.append('black')
             
             # Sağlığa göre boyut
-            sizes_animals.append(animal['health'] / 2)
+            sizes_animals.append(health / 2)
 
     # Bitkileri işle
     if frame < len(plant_data):
-        for plant in plant_data[frame]['plants']:
-            x_plants.append(plant['x'])
-            y_plants.append(plant['y'])
-            sizes_plants.append(plant['food'] / 5)
+        sizes_plants = plant_data[frame] / 5
 
     # Saçılma grafiklerini güncelle
     animal_scatter.set_offsets(np.c_[x_animals, y_animals])
@@ -1,9 +1,11 @@
+import os
 import json
 import ijson
 from decimal import Decimal
 from bokeh.plotting import figure, output_file, show
 from bokeh.layouts import column
 from bokeh.palettes import Set1
+from trajectory import read_trajectory
 
 def convert_decimals(obj):
     """
@@ -18,31 +20,45 @@ def convert_decimals(obj):
     else:
         return obj
 
+def is_ndjson_file(filename):
+    """
+    Return True if the file holds one JSON object per line rather than a single JSON array.
+    """
+    with open(filename, 'r') as f:
+        for line in f:
+            if line.strip():
+                return not line.lstrip().startswith('[')
+    return True
+
 def stream_large_json_file(filename):
     """
-    Stream JSON objects one by one from a large file.
+    Stream JSON objects one by one from a large file (JSON array or NDJSON).
     """
     with open(filename, 'r') as f:
-        for item in ijson.items(f, 'item'):
-            yield item
+        if is_ndjson_file(filename):
+            for line in f:
+                if line.strip():
+                    yield json.loads(line)
+        else:
+            for item in ijson.items(f, 'item'):
+                yield item
 
 def stream_animal_data(static_filename, dynamic_filename):
     """
-    Stream animal data from static and dynamic JSON files.
+    Stream animal data from the static JSON file and the binary trajectory file.
     """
     # Load static data first
     species_details = {}
-    with open(static_filename, 'r') as static_file:
-        static_data = convert_decimals(json.load(static_file))
-        for animal in static_data:
-            species_details[animal['id']] = {
-                'species_name': animal['species_name'],
-                'is_herbivore': animal['is_herbivore'],
-                'speed': animal['speed'],
-                'stealth_level': animal['stealth_level'],
-                'detection_skill': animal['detection_skill'],
-                'detection_range': animal['detection_range']
-            }
+    for animal in stream_large_json_file(static_filename):
+        animal = convert_decimals(animal)
+        species_details[animal['id']] = {
+            'species_name': animal['species_name'],
+            'is_herbivore': animal['is_herbivore'],
+            'speed': animal['speed'],
+            'stealth_level': animal['stealth_level'],
+            'detection_skill': animal['detection_skill'],
+            'detection_range': animal['detection_range']
+        }
 
     # Initialize statistics
     total_herbivores = []
@@ -57,8 +73,7 @@ def stream_animal_data(static_filename, dynamic_filename):
     speed_over_time = {}
 
     # Process dynamic data frame by frame
-    for step_data in stream_large_json_file(dynamic_filename):
-        step_data = convert_decimals(step_data)
+    for step_data in read_trajectory(dynamic_filename):
         frame_species_pop = {}
         frame_species_stealth = {}
         frame_species_detection = {}
@@ -73,14 +88,11 @@ def stream_animal_data(static_filename, dynamic_filename):
         herbivore_count = 0
         carnivore_count = 0
 
-        for animal in step_data['data']:
-            species_info = species_details.get(animal['id'], {})
+        for animal_id, hunger, health in zip(step_data['id'].tolist(), step_data['hunger'].tolist(), step_data['health'].tolist()):
+            species_info = species_details.get(animal_id, {})
             species_name = species_info.get('species_name', 'Unknown')
             is_herbivore = species_info.get('is_herbivore', False)
 
-            hunger = animal['hunger']
-            health = animal['health']
-
             if is_herbivore:
                 frame_herbivores += 1
                 frame_hunger_herbivores += hunger
@@ -143,37 +155,83 @@ def stream_animal_data(static_filename, dynamic_filename):
         'speed_over_time': speed_over_time,
     }
 
-def stream_plant_data(plant_filename):
+def stream_plant_data(plant_static_filename, plant_filename):
     """
-    Stream plant data from the JSON file and calculate average food level over time.
+    Stream plant data and calculate average food level over time.
+    Each step record holds the food of the plants that changed (all plants on keyframes),
+    so the current food of every plant is carried over from earlier steps.
     """
+    plant_count = sum(1 for _ in stream_large_json_file(plant_static_filename))
+    food = [0.0] * plant_count
+    total_food = 0.0
     avg_food_levels = []
 
     for step_data in stream_large_json_file(plant_filename):
         step_data = convert_decimals(step_data)
-        total_food = 0
-        plant_count = 0
-
-        for plant in step_data['plants']:
-            total_food += plant['food']
-            plant_count += 1
+        for plant_id, plant_food in zip(step_data['id'], step_data['food']):
+            total_food += plant_food - food[plant_id]
+            food[plant_id] = plant_food
+        if step_data['keyframe']:
+            total_food = sum(food)
 
         avg_food_levels.append(total_food / plant_count if plant_count > 0 else 0)
 
     return avg_food_levels
 
+def load_statistics(statistics_filename):
+    """
+    Load the per-step statistics table written by the simulation and return the same
+    series as stream_animal_data, plus the average plant food levels.
+    """
+    stats = {
+        'species_populations': {},
+        'total_herbivores': [],
+        'total_carnivores': [],
+        'hunger_herbivores': [],
+        'health_herbivores': [],
+        'hunger_carnivores': [],
+        'health_carnivores': [],
+        'stealth_levels_over_time': {},
+        'detection_skills_over_time': {},
+        'speed_over_time': {},
+    }
+    avg_food_levels = []
+
+    for step_data in stream_large_json_file(statistics_filename):
+        step_data = convert_decimals(step_data)
+        stats['total_herbivores'].append(step_data['herbivores'])
+        stats['total_carnivores'].append(step_data['carnivores'])
+        stats['hunger_herbivores'].append(step_data['herbivore_hunger'])
+        stats['health_herbivores'].append(step_data['herbivore_health'])
+        stats['hunger_carnivores'].append(step_data['carnivore_hunger'])
+        stats['health_carnivores'].append(step_data['carnivore_health'])
+        avg_food_levels.append(step_data['plant_food'])
+
+        for species_name, species_data in step_data['species'].items():
+            stats['species_populations'].setdefault(species_name, []).append(species_data['population'])
+            stats['stealth_levels_over_time'].setdefault(species_name, []).append(species_data['stealth_level'])
+            stats['detection_skills_over_time'].setdefault(species_name, []).append(species_data['detection_skill'])
+            stats['speed_over_time'].setdefault(species_name, []).append(species_data['speed'])
+
+    return stats, avg_food_levels
+
 # Specify the file paths
 num = '1'
 
 str_num = str(num)
 path_prefix = 'C:\\Users\\Doruk\\env\\tubitak2025\\json\\' + str_num +'\\'
 static_filename = path_prefix + 'animal_static_data.json'
-dynamic_filename = path_prefix + 'animal_dynamic_data.json'
+dynamic_filename = path_prefix + 'animal_dynamic_data.bin'
+plant_static_filename = path_prefix + 'plant_static_data.json'
 plant_filename = path_prefix + 'plant_data1.json'
+statistics_filename = path_prefix + 'statistics.json'
 
-# Process the data
-stats = stream_animal_data(static_filename, dynamic_filename)
-avg_plant_food_levels = stream_plant_data(plant_filename)
+# Process the data (the statistics table is enough when the simulation wrote it)
+if os.path.exists(statistics_filename):
+    stats, avg_plant_food_levels = load_statistics(statistics_filename)
+else:
+    stats = stream_animal_data(static_filename, dynamic_filename)
+    avg_plant_food_levels = stream_plant_data(plant_static_filename, plant_filename)
 
 # Setup output file for Bokeh
 output_file(path_prefix + "animal_evolution_with_plants.html")
@@ -0,0 +1,48 @@
+import struct
+import numpy as np
+
+HEADER = struct.Struct('<8sIIIIQ')
+STEP_HEADER = struct.Struct('<iI')
+INDEX_DTYPE = np.dtype([('step', '<i4'), ('count', '<u4'), ('offset', '<u8')])
+MAGIC = b'ABMTRAJ\0'
+
+def read_step(buf, offset):
+    """
+    Return the columns of the step block starting at offset as numpy views into buf.
+    """
+    step, count = STEP_HEADER.unpack_from(buf, offset)
+    pos = offset + STEP_HEADER.size
+    frame = {'step': step}
+    frame['id'] = np.frombuffer(buf, dtype='<i4', count=count, offset=pos)
+    pos += 4 * count
+    for name in ('x', 'y', 'health', 'hunger'):
+        frame[name] = np.frombuffer(buf, dtype='<f4', count=count, offset=pos)
+        pos += 4 * count
+    frame['state'] = np.frombuffer(buf, dtype='u1', count=count, offset=pos)
+    pos += (count + 3) // 4 * 4
+    return frame, pos
+
+def read_trajectory(filename):
+    """
+    Memory-map a binary trajectory file (animal_dynamic_data.bin) and yield one dict per step
+    with 'step', 'id', 'x', 'y', 'health', 'hunger' and 'state'. Uses the step index when the
+    file was closed properly, otherwise walks the step blocks in order.
+    """
+    buf = np.memmap(filename, dtype='u1', mode='r')
+    magic, version, header_size, column_count, step_count, index_offset = HEADER.unpack_from(buf, 0)
+    if magic != MAGIC or version != 1:
+        raise ValueError(f'{filename}: not a version 1 trajectory file')
+
+    if index_offset != 0:
+        index = np.frombuffer(buf, dtype=INDEX_DTYPE, count=step_count, offset=index_offset)
+        for entry in index:
+            yield read_step(buf, int(entry['offset']))[0]
+    else:
+        # The last block of an interrupted run may be incomplete; stop before it.
+        pos = header_size
+        while pos + STEP_HEADER.size <= len(buf):
+            count = STEP_HEADER.unpack_from(buf, pos)[1]
+            if pos + STEP_HEADER.size + 20 * count + (count + 3) // 4 * 4 > len(buf):
+                break
+            frame, pos = read_step(buf, pos)
+            yield frame